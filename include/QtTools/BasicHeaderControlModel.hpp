@@ -7,10 +7,12 @@
 
 #include <QtWidgets/QHeaderView>
 #include <QtTools/ToolsBase.hpp>
+#include <QtTools/ToggleChecked.hpp>
 
 #include <vector>
 #include <algorithm>
 #include <functional>
+#include <unordered_set>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/hashed_index.hpp>
@@ -29,7 +31,8 @@ namespace QtTools
 	///     модель вызовет необходимые методы отслеживаемого QHeaderView,
 	///     что бы привести отслеживаемый QHeaderView в соответствие.
 	///
-	/// видимость колонок представлена Qt::CheckStateRole
+	/// видимость колонок представлена Qt::CheckStateRole,
+	/// массовое изменение видимости поддерживается через CheckStateBulkAccess(смотри ToggleChecked)
 	/// модель идентифицирует колонки по кодам, это позволяет работать в ситуации когда:
 	///   * таблица заполняется в фоне и колонки могут приходит не сразу, а в процессе загрузки с задержкой
 	///   * мы хотим запоминать порядок колонок между сеансами приложения
@@ -59,7 +62,7 @@ namespace QtTools
 	/// @Param BaseModel QAbstrctItemModel которую наследует данный класс, по-умолчанию QAbstractListModel
 	/// 
 	template <class SectionInfoTraits, class BaseModel = QAbstractListModel>
-	class BasicHeaderControlModel : public BaseModel, protected SectionInfoTraits
+	class BasicHeaderControlModel : public BaseModel, public CheckStateBulkAccess, protected SectionInfoTraits
 	{
 		typedef BaseModel               base_type;
 		typedef BasicHeaderControlModel self_type;
@@ -128,6 +131,79 @@ namespace QtTools
 
 		const IsPresentType IsPresent = IsPresentType();
 
+		/// Порядковая статистика по признаку IsPresent секций m_sectionContainer(дерево Фенвика).
+		/// Позволяет переводить внутренний индекс в визуальный и обратно за O(log n).
+		/// Структурные изменения контейнера(вставка, удаление, перемещение) только помечают индекс как невалидный,
+		/// он перестраивается за O(n) при следующем запросе; изменение присутствия отдельной секции - O(log n)
+		class PresenceIndex
+		{
+			std::vector<int> m_tree; // 1-based
+			bool m_valid = false;
+
+		public:
+			bool IsValid() const noexcept { return m_valid; }
+			void Invalidate() noexcept { m_valid = false; }
+
+			/// перестраивает индекс по range за O(n)
+			template <class Range, class Pred>
+			void Rebuild(const Range & range, Pred pred)
+			{
+				const int n = qint(range.size());
+				m_tree.assign(n + 1, 0);
+
+				int i = 1;
+				for (const auto & val : range)
+					m_tree[i++] = pred(val) ? 1 : 0;
+
+				for (i = 1; i <= n; ++i)
+				{
+					int parent = i + (i & -i);
+					if (parent <= n) m_tree[parent] += m_tree[i];
+				}
+
+				m_valid = true;
+			}
+
+			/// изменяет счетчик элемента с индексом index на delta
+			void Update(int index, int delta) noexcept
+			{
+				const int n = qint(m_tree.size()) - 1;
+				for (++index; index <= n; index += index & -index)
+					m_tree[index] += delta;
+			}
+
+			/// количество присутствующих элементов среди первых count
+			int PrefixCount(int count) const noexcept
+			{
+				int result = 0;
+				for (; count > 0; count -= count & -count)
+					result += m_tree[count];
+
+				return result;
+			}
+
+			/// минимальное count, такое что PrefixCount(count) >= k, если такого нет - размер
+			int LowerBound(int k) const noexcept
+			{
+				const int n = qint(m_tree.size()) - 1;
+				if (k <= 0) return 0;
+
+				int pos = 0, step = 1;
+				while (step * 2 <= n) step *= 2;
+
+				for (; step; step /= 2)
+				{
+					if (pos + step <= n and m_tree[pos + step] < k)
+					{
+						pos += step;
+						k -= m_tree[pos];
+					}
+				}
+
+				return std::min(pos + 1, n);
+			}
+		};
+
 		/// небольшой вспомогательный RAII класс для bool флажка
 		class pass_slot_lock
 		{
@@ -146,6 +222,8 @@ namespace QtTools
 
 	protected:
 		SectionContainer m_sectionContainer;
+		// смотри PresenceIndex, должен инвалидироваться при любом структурном изменении m_sectionContainer
+		mutable PresenceIndex m_presenceIndex;
 		QHeaderView * m_headerView = nullptr;
 		QAbstractItemModel * m_headerModel = nullptr;
 		bool m_pass_slot = false;
@@ -179,6 +257,11 @@ namespace QtTools
 		/// получает визуальный индекс по коду
 		int VisualIndexFromIt(BySeqViewConstIterator seqit) const;
 
+		/// возвращает актуальный m_presenceIndex, перестраивая его при необходимости
+		const PresenceIndex & GetPresenceIndex() const;
+		/// выставляет logicalIndex секции, поддерживая m_presenceIndex
+		void SetLogicalIndex(BySeqViewConstIterator it, int logicalIndex);
+
 	public:
 		/// получает внутренний индекс по визуальному индексу QHeaderView
 		/// NOTE: спрятанные секции не исчезают из нумерации
@@ -222,6 +305,10 @@ namespace QtTools
 		/// добавляет секцию info к QHeaderView,
 		/// если такая секция уже была(с таким кодом) она будет сконфигурирована новой информацией
 		void AssignSection(section_info && info);
+		/// приводит отслеживаемый QHeaderView в соответствие с внутренним состоянием одним пакетом:
+		/// порядок - минимальным проходом moveSection(секции уже стоящие на месте не трогаются),
+		/// размеры и видимость - только для отличающихся секций. Собственные слоты реакции на сигналы QHeaderView при этом игнорируются
+		void ApplyToHeader();
 
 	public:
 		// model support
@@ -232,6 +319,12 @@ namespace QtTools
 		/// если есть отслеживаемый QHeaderView - генерирует вызовы setSectionHidden
 		bool setData(const QModelIndex & index, const QVariant & value, int role = Qt::EditRole) override;
 
+		// CheckStateBulkAccess
+		int CheckStateCount(const QModelIndex & parent, int column, int first, int last, Qt::CheckState state) const override;
+		/// выставляет видимость диапазону строк, QHeaderView меняется только для отличающихся секций,
+		/// генерирует один dataChanged на весь диапазон
+		bool SetCheckStateRange(const QModelIndex & parent, int column, int first, int last, Qt::CheckState state) override;
+
 		/// перемещает строки, если есть отслеживаемый QHeaderView - генерирует вызовы sectionMoved.
 		/// таким образом синхронизирует QHeaderView с внутренним состоянием
 		bool moveRows(const QModelIndex & sourceParent, int sourceRow, int count,
@@ -330,37 +423,44 @@ namespace QtTools
 	/************************************************************************/
 	/*                    Index methods                                     */
 	/************************************************************************/
+	template <class SectionInfoTraits, class BaseModel>
+	auto BasicHeaderControlModel<SectionInfoTraits, BaseModel>::GetPresenceIndex() const -> const PresenceIndex &
+	{
+		if (not m_presenceIndex.IsValid())
+			m_presenceIndex.Rebuild(m_sectionContainer, IsPresent);
+
+		return m_presenceIndex;
+	}
+
+	template <class SectionInfoTraits, class BaseModel>
+	void BasicHeaderControlModel<SectionInfoTraits, BaseModel>::SetLogicalIndex(BySeqViewConstIterator it, int logicalIndex)
+	{
+		section_info & s = const_cast<section_info &>(*it);
+		bool wasPresent = IsPresent(s);
+		s.logicalIndex = logicalIndex;
+		bool present = IsPresent(s);
+
+		if (wasPresent != present and m_presenceIndex.IsValid())
+			m_presenceIndex.Update(IndexFromIt(it), present ? +1 : -1);
+	}
+
 	template <class SectionInfoTraits, class BaseModel>
 	int BasicHeaderControlModel<SectionInfoTraits, BaseModel>::VisualIndexFromIt(BySeqViewConstIterator seqit) const
 	{
-		auto first = m_sectionContainer.begin();
-		int count = 0;
-		for (; first != seqit; ++first)
-			if (IsPresent(*first)) ++count;
-		return count;
+		return GetPresenceIndex().PrefixCount(IndexFromIt(seqit));
 	}
 
 	template <class SectionInfoTraits, class BaseModel>
 	int BasicHeaderControlModel<SectionInfoTraits, BaseModel>::VisualIndexToIndex(int visualIndex) const
 	{
-		auto first = m_sectionContainer.begin();
-		auto it = first;
-		for (; visualIndex; ++it)
-			if (IsPresent(*it)) --visualIndex;
-
-		return qint(it - first);
+		// позиция сразу за visualIndex-ой присутствующей секцией
+		return GetPresenceIndex().LowerBound(visualIndex);
 	}
 
 	template <class SectionInfoTraits, class BaseModel>
 	int BasicHeaderControlModel<SectionInfoTraits, BaseModel>::VisualIndexFromIndex(int internalIndex) const
 	{
-		auto first = m_sectionContainer.begin();
-		auto last = first + internalIndex;
-		int visualIndex = 0;
-		for (; first != last; ++first)
-			if (IsPresent(*first)) ++visualIndex;
-
-		return visualIndex;
+		return GetPresenceIndex().PrefixCount(internalIndex);
 	}
 
 	/************************************************************************/
@@ -437,6 +537,7 @@ namespace QtTools
 		auto last = first + count;
 		auto dest = m_sectionContainer.begin() + destinationChild;
 		m_sectionContainer.relocate(dest, first, last);
+		m_presenceIndex.Invalidate();
 
 		this->endMoveRows();
 		return true;
@@ -502,13 +603,14 @@ namespace QtTools
 
 		if (inserted)
 		{
+			m_presenceIndex.Invalidate();
 			int pos = IndexFromIt(seqit);
 			this->beginInsertRows({}, pos, pos);
 			this->endInsertRows();
 		}
 		else
 		{
-			const_cast<section_info &>(*it).logicalIndex = li;
+			SetLogicalIndex(seqit, li);
 			SetSectionSize(seqit, get_width(*seqit), true);
 			SetSectionHidden(seqit, get_hidden(*seqit), true);
 
@@ -581,6 +683,45 @@ namespace QtTools
 		return true;
 	}
 
+	template <class SectionInfoTraits, class BaseModel>
+	int BasicHeaderControlModel<SectionInfoTraits, BaseModel>::CheckStateCount(const QModelIndex & parent, int column, int first, int last, Qt::CheckState state) const
+	{
+		// секции бывают только видимыми или скрытыми
+		if (state == Qt::PartiallyChecked) return 0;
+
+		const bool hidden = state == Qt::Unchecked;
+		auto firstIt = m_sectionContainer.begin() + first;
+		auto lastIt = m_sectionContainer.begin() + last + 1;
+		return qint(std::count_if(firstIt, lastIt, [hidden](const section_info & s) { return get_hidden(s) == hidden; }));
+	}
+
+	template <class SectionInfoTraits, class BaseModel>
+	bool BasicHeaderControlModel<SectionInfoTraits, BaseModel>::SetCheckStateRange(const QModelIndex & parent, int column, int first, int last, Qt::CheckState state)
+	{
+		if (first < 0 or last >= rowCount() or first > last)
+			return false;
+
+		const bool hidden = state == Qt::Unchecked;
+		{
+			// реакция на sectionResized от setSectionHidden не нужна - состояние уже выставлено
+			pass_slot_lock lk {m_pass_slot};
+			auto firstIt = m_sectionContainer.begin() + first;
+			auto lastIt = m_sectionContainer.begin() + last + 1;
+
+			for (auto it = firstIt; it != lastIt; ++it)
+			{
+				section_info & s = const_cast<section_info &>(*it);
+				set_hidden(s, hidden);
+
+				if (m_headerView && IsPresent(s) && m_headerView->isSectionHidden(s.logicalIndex) != hidden)
+					m_headerView->setSectionHidden(s.logicalIndex, hidden);
+			}
+		}
+
+		Q_EMIT this->dataChanged(this->index(first), this->index(last), {Qt::CheckStateRole});
+		return true;
+	}
+
 	template <class SectionInfoTraits, class BaseModel>
 	bool BasicHeaderControlModel<SectionInfoTraits, BaseModel>::moveRows(const QModelIndex & sourceParent, int sourceRow, int count,
 	                                                                     const QModelIndex & destinationParent, int destinationChild)
@@ -697,6 +838,9 @@ namespace QtTools
 	template <class SectionInfoTraits, class BaseModel>
 	void BasicHeaderControlModel<SectionInfoTraits, BaseModel>::OnSectionSizeChanged(int logicalIndex, int oldSize, int newWidth)
 	{
+		if (m_pass_slot)
+			return;
+
 		code_type code = CodeFromLogicalIndex(logicalIndex);
 		OnSectionSizeChanged(code, newWidth);
 
@@ -759,6 +903,7 @@ namespace QtTools
 
 			// update now
 			bool replaced = m_sectionContainer.replace(seqit, info);
+			m_presenceIndex.Invalidate();
 			if (replaced)
 			{
 				// заменить удалось, имя изменилось на какое-то, которое нам еще не известно
@@ -773,6 +918,7 @@ namespace QtTools
 				int row = seqit - first;
 				this->beginRemoveRows({}, row, row);
 				m_sectionContainer.erase(seqit);
+				m_presenceIndex.Invalidate();
 				this->endRemoveRows();
 				// устанавливаем секцию и синхронизируем View
 				AssignSection(std::move(info));
@@ -829,6 +975,8 @@ namespace QtTools
 			const_cast<section_info &>(info).logicalIndex = section_info::notpresent;
 		}
 
+		m_presenceIndex.Invalidate();
+
 		auto count = m_headerModel->columnCount();
 		auto oldSz = m_sectionContainer.size();
 		
@@ -857,6 +1005,7 @@ namespace QtTools
 		});
 
 		m_sectionContainer.rearrange(tmpview.begin());
+		m_presenceIndex.Invalidate();
 	}
 
 	template <class SectionInfoTraits, class BaseModel>
@@ -924,28 +1073,86 @@ namespace QtTools
 
 		auto & codeview = m_sectionContainer.template get<ByCode>();
 
-		int pos = 0;
+		// сначала только внутреннее состояние: сконфигурированные секции в заданном порядке,
+		// за ними остальные в прежнем относительном порядке. QHeaderView на этом этапе не трогаем
+		std::vector<std::reference_wrapper<const section_info>> order;
+		std::unordered_set<const section_info *> configured;
+		order.reserve(m_sectionContainer.size());
+
 		for (auto && s : sections)
 		{
+			bool hidden = traits_type::get_hidden(s);
+			int width = traits_type::get_width(s);
+
 			bool inserted;
 			ByCodeViewConstIterator it;
 			std::tie(it, inserted) = codeview.emplace(std::move(s));
-			auto seqIt = ToSeqIterator(it);
 
+			section_info & info = const_cast<section_info &>(*it);
 			if (!inserted)
 			{
 				// данная секция уже была, настраиваем ее
-				SetSectionHidden(seqIt, traits_type::get_hidden(s), true);
-				SetSectionSize(seqIt, traits_type::get_width(s), true);
+				set_hidden(info, hidden);
+				// 0 используется QHeaderView при сокрытии секций, смотри SetSectionSize
+				if (width > 0) set_width(info, width);
 			}
 
-			MoveSection(seqIt, pos);
-			++pos;
+			if (configured.insert(&info).second)
+				order.push_back(std::cref(info));
 		}
 
+		for (const section_info & info : m_sectionContainer)
+			if (not configured.count(&info))
+				order.push_back(std::cref(info));
+
+		m_sectionContainer.rearrange(order.begin());
+		m_presenceIndex.Invalidate();
+
+		if (m_headerView) ApplyToHeader();
 		this->endResetModel();
 	}
 
+	template <class SectionInfoTraits, class BaseModel>
+	void BasicHeaderControlModel<SectionInfoTraits, BaseModel>::ApplyToHeader()
+	{
+		BOOST_ASSERT(m_headerView);
+		pass_slot_lock lk {m_pass_slot};
+
+		// присутствующие секции в порядке контейнера задают целевой визуальный порядок:
+		// k-ая присутствующая секция должна стоять на визуальной позиции k.
+		// Проходим позиции слева направо, и переносим на место только секции, стоящие не на своем месте,
+		// секции уже стоящие на своем месте(например конфигурация совпадает с текущей) не требуют вызовов moveSection
+		int visualIndex = 0;
+		for (const section_info & info : m_sectionContainer)
+		{
+			if (not IsPresent(info)) continue;
+
+			int current = m_headerView->visualIndex(info.logicalIndex);
+			if (current != visualIndex)
+				m_headerView->moveSection(current, visualIndex);
+
+			++visualIndex;
+		}
+
+		for (const section_info & info : m_sectionContainer)
+		{
+			if (not IsPresent(info)) continue;
+
+			int li = info.logicalIndex;
+			int width = get_width(info);
+			bool hidden = get_hidden(info);
+
+			// размер выставляем до изменения видимости: для скрытой секции QHeaderView только запоминает размер
+			// и применит его при показе, а при сокрытии запомнит уже новый размер
+			bool headerHidden = m_headerView->isSectionHidden(li);
+			if (width > 0 and (headerHidden or m_headerView->sectionSize(li) != width))
+				m_headerView->resizeSection(li, width);
+
+			if (headerHidden != hidden)
+				m_headerView->setSectionHidden(li, hidden);
+		}
+	}
+
 	template <class SectionInfoTraits, class BaseModel>
 	bool BasicHeaderControlModel<SectionInfoTraits, BaseModel>::IsNaturalOrder() const
 	{
@@ -981,6 +1188,7 @@ namespace QtTools
 		{
 			this->beginResetModel();
 			m_sectionContainer.clear();
+			m_presenceIndex.Invalidate();
 			this->endResetModel();
 		}
 		else
@@ -1012,6 +1220,8 @@ namespace QtTools
 			else
 				++it;
 		}
+
+		m_presenceIndex.Invalidate();
 		this->endResetModel();
 	}
 }
@@ -1,6 +1,10 @@
 ﻿#pragma once
+#include <list>
 #include <QtCore/QVector>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
 #include <QtGui/QTextLayout>
+#include <QtGui/QStaticText>
 #include <QtWidgets/QStyleOption>
 #include <QtTools/Delegates/Utils.hpp>
 
@@ -84,6 +88,16 @@ namespace Delegates
 		inline void DrawLayout(QPainter * painter, const QPointF & drawPos, const QTextLayout & layout)
 		{ return DrawLayout(painter, drawPos, layout, layout.lineCount()); }
 
+		/// рисует усеченную линию elideIndex из layout в lineRect(смотри описание DoLayout).
+		/// В отличие от ElideText + повторной разметки, точка усечения вычисляется по позициям глифов уже размеченной линии,
+		/// видимые части линии рисуются с отсечением, а символ многоточия(U+2026) рисуется отдельно -
+		/// таким образом текст размечается только один раз.
+		/// Учитывается mode(Qt::ElideRight, Qt::ElideLeft, Qt::ElideMiddle, Qt::ElideNone), выравнивание и направление текста из layout.textOption().
+		/// ellipsisFormats - если скрытая часть текста пересекается с одним из форматов,
+		/// многоточие рисуется с его фоном и цветом(например подсветка найденного текста)
+		void DrawElidedLine(QPainter * painter, const QRect & lineRect, const QTextLayout & layout, int elideIndex,
+		                    Qt::TextElideMode mode, const QVector<QTextLayout::FormatRange> & ellipsisFormats = {});
+
 	}
 
 	/// Подготавливает painter для дальнейшего рисования
@@ -95,6 +109,53 @@ namespace Delegates
 	/// textRect следует получать с помощью QtTools::Delegates::TextSubrect(opt), это базовый способ QStyledItemDelegate
 	void DrawEditingFrame(QPainter * painter, const QRect & textRect, const QStyleOptionViewItem & opt);
 
+	/// Кеш подготовленных QStaticText для DrawPlainText.
+	/// Ключ - текст и шрифт, при превышении лимита вытесняются давно не использованные элементы(LRU).
+	/// В кеш попадает только повторяющийся текст: при первом обращении запоминается лишь хеш ключа,
+	/// и Acquire возвращает nullptr - такой текст дешевле нарисовать напрямую(уникальные числа, цены, идентификаторы).
+	class StaticTextCache
+	{
+	protected:
+		struct Key
+		{
+			QString text;
+			QFont font;
+
+			bool operator ==(const Key & other) const noexcept { return text == other.text and font == other.font; }
+		};
+
+		friend uint qHash(const Key & key, uint seed) noexcept;
+
+		using ItemList = std::list<std::pair<Key, QStaticText>>;
+
+	protected:
+		ItemList m_items;                           // most recently used are at front
+		QHash<Key, ItemList::iterator> m_index;
+		QSet<uint> m_seen;                          // хеши ключей, встреченных один раз
+		int m_limit = 2048;
+
+	public:
+		/// возвращает подготовленный QStaticText для text с шрифтом font.
+		/// Если text с этим шрифтом встречен впервые - возвращает nullptr, см. описание класса
+		const QStaticText * Acquire(const QString & text, const QFont & font);
+
+		void Clear();
+		int  GetLimit() const      { return m_limit; }
+		void SetLimit(int limit);
+	};
+
+	/// проверяет, является ли text простой одиночной строкой:
+	/// не содержит переводов строк, разделителей строк/параграфов и табуляций
+	bool IsSingleLineText(const QString & text) noexcept;
+
+	/// Быстрый путь рисования текста без форматов: однострочный текст, целиком помещающийся в textRect,
+	/// рисуется с помощью закешированного QStaticText, без QTextLayout и усечения.
+	/// Если текст не однострочный или не помещается - ничего не рисует и возвращает false,
+	/// в этом случае следует использовать DrawFormattedText.
+	/// Данный метод не вызывает PreparePainter, RemoveTextMargin.
+	bool DrawPlainText(QPainter * painter, const QString & text, const QRect & textRect, const QStyleOptionViewItem & opt,
+	                   StaticTextCache & cache);
+
 	/// Рисует текст text в textRect painter'а с помощью QTextLayout, учитывая параметры из opt.
 	/// Данный метод не вызывает PreparePainter, RemoveTextMargin.
 	/// additionalFormats - дополнительные форматы для opt.text
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <QtCore/QString>
 #include <QtTools/Delegates/StyledDelegate.hpp>
 #include <QtTools/Delegates/DrawFormattedText.hpp>
@@ -13,11 +14,41 @@ namespace Delegates
 	void DrawSearchFormatedText(QPainter * painter, const QString & text, const QRect & textRect, const QStyleOptionViewItem & opt,
 	                            const QVector<QTextLayout::FormatRange> & selectionFormats);
 
+	/// Предварительно подготовленный регистронезависимый поиск подстроки.
+	/// Образец один раз приводится к case folded форме и для него строится таблица сдвигов(Boyer-Moore-Horspool),
+	/// поиск выполняется за один линейный проход по тексту, символы текста приводятся на лету, без выделения памяти.
+	class SearchMatcher
+	{
+	protected:
+		QString m_pattern;              // исходный образец
+		QString m_needle;               // образец в case folded форме
+		std::array<int, 256> m_skip;    // таблица сдвигов, индексируется младшим байтом case folded символа
+
+	public:
+		const QString & GetPattern() const noexcept { return m_pattern; }
+		void SetPattern(const QString & pattern);
+
+		bool IsEmpty() const noexcept { return m_needle.isEmpty(); }
+		int  Length()  const noexcept { return m_needle.length(); }
+
+		/// ищет образец в text начиная с from, возвращает индекс найденного вхождения или -1
+		int IndexIn(const QString & text, int from = 0) const noexcept;
+
+	public:
+		SearchMatcher() = default;
+		SearchMatcher(const QString & pattern) { SetPattern(pattern); }
+	};
+
 	/// "Раскрашивает" text в соответствии с filterWord
 	/// слово ищется в text, совпадения раскрашивается в заданный формат
 	void FormatSearchText(const QString & text, const QString & filterWord,
 	                      const QTextCharFormat & format, QVector<QTextLayout::FormatRange> & formats);
 
+	/// "Раскрашивает" text в соответствии с подготовленным matcher
+	/// если совпадений нет - formats не изменяется и память не выделяется
+	void FormatSearchText(const QString & text, const SearchMatcher & matcher,
+	                      const QTextCharFormat & format, QVector<QTextLayout::FormatRange> & formats);
+
 	/// "Раскрашивает" text в соответствии с filterWord, return форма.
 	/// слово ищется в text, совпадения раскрашивается в заданный формат
 	auto FormatSearchText(const QString & text, const QString & filterWord, const QTextCharFormat & format)
@@ -33,6 +64,10 @@ namespace Delegates
 	protected:
 		QString m_searchText;
 		QTextCharFormat m_format;
+		// подготовленный поиск m_searchText, обновляется в SetFilterText
+		SearchMatcher m_matcher;
+		// переиспользуемый между вызовами DrawText буфер форматов
+		mutable QVector<QTextLayout::FormatRange> m_formats;
 
 	protected:
 		/// форматирует текст text в соответствии с m_searchText в formats
@@ -42,7 +77,7 @@ namespace Delegates
 
 	public:
 		QString GetFilterText() const { return m_searchText; }
-		void    SetFilterText(const QString text) { m_searchText = text; }
+		void    SetFilterText(const QString text) { m_searchText = text; m_matcher.SetPattern(m_searchText); }
 
 		const QTextCharFormat & GetFormat() const                         { return m_format; }
 		void                    SetFormat(const QTextCharFormat & format) { m_format = format; }
@@ -1,8 +1,13 @@
 ﻿#pragma once
+#include <QtCore/QHash>
+#include <QtCore/QPointer>
+#include <QtGui/QFont>
 #include <QtWidgets/QWidget>
 #include <QtWidgets/QStyle>
 #include <QtWidgets/QStyleOption>
 #include <QtWidgets/QStyledItemDelegate>
+#include <QtTools/Delegates/StyledParts.hpp>
+#include <QtTools/Delegates/DrawFormattedText.hpp>
 
 namespace QtTools {
 namespace Delegates
@@ -15,9 +20,40 @@ namespace Delegates
 	///   QtTools/Delegates/DrawFormattedText.h
 	class StyledDelegate : public QStyledItemDelegate
 	{
+	protected:
+		/// кеш QStaticText для быстрого рисования простого текста(смотри DrawPlainText)
+		mutable StaticTextCache m_textCache;
+		/// метрики стиля view, в котором последний раз происходило рисование(смотри StyleMetrics)
+		mutable QPointer<StyleMetrics> m_metrics;
+
+	protected:
+		/// ключ кеша sizeHint: все, от чего зависит QStyle::sizeFromContents(CT_ItemViewItem)
+		struct SizeHintKey
+		{
+			QString text;
+			QFont font;
+			QSize decorationSize;
+			int features;
+			int decorationPosition;
+			int width; // ширина учитывается только при переносе текста(WrapText), иначе -1
+
+			bool operator ==(const SizeHintKey & other) const noexcept;
+		};
+
+		friend uint qHash(const SizeHintKey & key, uint seed) noexcept;
+
+		/// кеш sizeHint, для таблиц с одним шрифтом большинство запросов - повторные.
+		/// Сбрасывается при смене стиля виджета или при превышении лимита, шрифт является частью ключа
+		mutable QHash<SizeHintKey, QSize> m_sizeHintCache;
+		mutable const QStyle * m_sizeHintStyle = nullptr;
+		int m_sizeHintCacheLimit = 10000;
+
 	protected:
 		/// иницилизирует option из index, дефолтная реализация вызывает initFromOption
 		virtual void InitStyle(QStyleOptionViewItem & option, const QModelIndex & index) const;
+		/// возвращает закешированные метрики стиля для option.widget,
+		/// повторные обращения для того же view обходятся без поиска
+		const StyleMetrics & Metrics(const QStyleOptionViewItem & option) const;
 
 		/// функции принимает painter и option, если наследнику нужна доп информация -
 		/// то или писать свои функции, или выставлять некий временный член, или расширить option
@@ -25,26 +61,27 @@ namespace Delegates
 		/// может быть модифицирован по желанию
 
 		/// рисует фон, дефолтная реализация:
-		/// Delegates::DrawBackground(painter, option);
+		/// Delegates::DrawBackground(painter, Metrics(option), option);
 		virtual void DrawBackground(QPainter * painter, QStyleOptionViewItem & option) const;
 		/// рисует кряж, дефолтная реализация:
-		/// Delegates::DrawCheckmark(painter, Delegates::CheckmarkSubrect(option), option);
+		/// Delegates::DrawCheckmark(painter, Metrics(option), Delegates::CheckmarkSubrect(Metrics(option), option), option);
 		virtual void DrawCheckmark(QPainter * painter, QStyleOptionViewItem & option) const;
 		/// рисует значок, дефолтная реализация:
-		/// Delegates::DrawDecoration(painter, Delegates::DecorationSubrect(option), option);
+		/// Delegates::DrawDecoration(painter, Delegates::DecorationSubrect(Metrics(option), option), option);
 		virtual void DrawDecoration(QPainter * painter, QStyleOptionViewItem & option) const;
 		/// рисует текст, дефолтная реализация:
-		/// Delegates::DrawFormattedText(painter, Delegates::TextSubrect(option), option);
+		/// Delegates::DrawPlainText(painter, Delegates::TextSubrect(Metrics(option), option), option, m_textCache),
+		/// если текст не однострочный или не помещается - Delegates::DrawFormattedText(painter, Delegates::TextSubrect(Metrics(option), option), option);
 		virtual void DrawText(QPainter * painter, QStyleOptionViewItem & option) const;
 		/// рисует рамку фокуса, дефолтная реализация:
-		/// Delegates::DrawFocusFrame(painter, Delegates::FocusFrameSubrect(option), option);
+		/// Delegates::DrawFocusFrame(painter, Metrics(option), Delegates::FocusFrameSubrect(Metrics(option), option), option);
 		virtual void DrawFocusFrame(QPainter * painter, QStyleOptionViewItem & option) const;
 
 	public:
 		/// реализация метода paint.
 		/// 
 		/// метод вызывает InitStyle,
-		/// после чего делает Delegates::FixStyleOptionViewItem(opt)
+		/// после чего делает Delegates::FixStyleOptionViewItem(opt, Metrics(opt))
 		/// 
 		/// painter->save();
 		/// painter->setClipRect(opt.rect);
@@ -55,8 +92,17 @@ namespace Delegates
 		/// т.е. if (HasCheckmark) DrawCheckmark и т.д.
 		/// порядок рисования: DrawBackground -> DrawCheckmark -> DrawDecoration -> DrawText -> DrawFocusFrame
 		void paint(QPainter * painter, const QStyleOptionViewItem & option, const QModelIndex & index) const override;
+		/// реализация метода sizeHint.
+		/// метод вызывает InitStyle, и возвращает QStyledItemDelegate::sizeHint, результат кешируется по SizeHintKey.
+		/// Если модель предоставляет Qt::SizeHintRole - кеш не используется
 		QSize sizeHint(const QStyleOptionViewItem & option, const QModelIndex & index) const override;
 
+		/// сбрасывает кеш sizeHint, следует вызывать если наследник меняет логику InitStyle/размеров
+		void ClearSizeHintCache() { m_sizeHintCache.clear(); }
+		/// лимит элементов в кеше sizeHint, 0 - кеширование отключено
+		int  GetSizeHintCacheLimit() const { return m_sizeHintCacheLimit; }
+		void SetSizeHintCacheLimit(int limit);
+
 	public:
 		StyledDelegate(QObject * parent = nullptr)
 			: QStyledItemDelegate(parent) {}
@@ -1,4 +1,6 @@
 #pragma once
+#include <QtCore/QObject>
+#include <QtCore/QHash>
 #include <QtWidgets/QWidget>
 #include <QtWidgets/QStyle>
 #include <QtWidgets/QStyleOption>
@@ -19,6 +21,81 @@ namespace Delegates
 	/// перед тем как передать opt для дальнейшего рисования в QCommonStyle, мы должны так же, увы
 	void FixStyleOptionViewItem(QStyleOptionViewItem & opt);
 
+	class StyleMetrics;
+	/// аналогично FixStyleOptionViewItem(opt), но проверка стиля берется из закешированных метрик
+	void FixStyleOptionViewItem(QStyleOptionViewItem & opt, const StyleMetrics & metrics);
+
+	/************************************************************************/
+	/*            StyleMetrics                                              */
+	/************************************************************************/
+	/// Закешированные метрики стиля виджета(view) для рисования элементов.
+	/// Хранится как дочерний объект виджета, получать следует через AccquireStyleMetrics.
+	/// Пересчитывается при смене стиля, шрифта или палитры виджета(QEvent::StyleChange, FontChange, PaletteChange).
+	/// 
+	/// Подобласти элемента(SE_ItemViewItem*) для qt стилей не зависят от текста элемента,
+	/// только от геометрии и флагов option, при этом QCommonStyle для SE_ItemViewItemText раскладывает текст.
+	/// Поэтому подобласти кешируются по SubrectsKey, для таблиц большинство запросов - повторные
+	class StyleMetrics : public QObject
+	{
+	public:
+		/// подобласти элемента, смотри CheckmarkSubrect, DecorationSubrect, TextSubrect, FocusFrameSubrect
+		struct Subrects
+		{
+			QRect check, decoration, text, focus;
+		};
+
+	protected:
+		/// ключ кеша подобластей: все, от чего зависит QStyle::subElementRect(SE_ItemViewItem*)
+		struct SubrectsKey
+		{
+			QRect rect;
+			QSize decorationSize;
+			int features;
+			int state;
+			int checkState;
+			int viewItemPosition; // style sheet может задавать правила для :first, :last и т.д.
+			int decorationPosition;
+			int decorationAlignment;
+			int displayAlignment;
+			int direction;
+
+			bool operator ==(const SubrectsKey & other) const noexcept;
+		};
+
+		friend uint qHash(const SubrectsKey & key, uint seed) noexcept;
+
+	protected:
+		QWidget * m_widget;
+		QStyle * m_style = nullptr;
+		int m_textMargin = 0;
+		bool m_windowsVistaStyle = false;
+
+		mutable QHash<SubrectsKey, Subrects> m_subrects;
+		static constexpr int SubrectsCacheLimit = 512;
+
+	public:
+		QWidget * GetWidget() const { return m_widget; }
+		QStyle * GetStyle() const { return m_style; }
+		/// horizontal text margin, смотри TextMargin(QStyle *)
+		int GetTextMargin() const { return m_textMargin; }
+		/// стиль является QWindowsVistaStyle, смотри FixStyleOptionViewItem
+		bool IsWindowsVistaStyle() const { return m_windowsVistaStyle; }
+
+		/// возвращает подобласти элемента для opt, вычисленные стилем или из кеша
+		const Subrects & GetSubrects(const QStyleOptionViewItem & opt) const;
+
+		/// пересчитывает метрики и сбрасывает кеш подобластей
+		void Refresh();
+		bool eventFilter(QObject * watched, QEvent * event) override;
+
+	public:
+		explicit StyleMetrics(QWidget * widget);
+	};
+
+	/// возвращает метрики стиля для opt.widget, создает их при первом обращении.
+	/// Если стиль виджета сменился без уведомления - метрики пересчитываются
+	StyleMetrics & AccquireStyleMetrics(const QStyleOptionViewItem & opt);
+
 	/************************************************************************/
 	/*             HasMethods                                               */
 	/************************************************************************/
@@ -77,6 +154,27 @@ namespace Delegates
 		return style->subElementRect(QStyle::SE_ItemViewItemFocusRect, &opt, opt.widget);
 	}
 
+	/// аналогичны функциям выше, но подобласти берутся из кеша метрик, смотри StyleMetrics
+	inline QRect CheckmarkSubrect(const StyleMetrics & metrics, const QStyleOptionViewItem & opt)
+	{
+		return metrics.GetSubrects(opt).check;
+	}
+
+	inline QRect DecorationSubrect(const StyleMetrics & metrics, const QStyleOptionViewItem & opt)
+	{
+		return metrics.GetSubrects(opt).decoration;
+	}
+
+	inline QRect TextSubrect(const StyleMetrics & metrics, const QStyleOptionViewItem & opt)
+	{
+		return metrics.GetSubrects(opt).text;
+	}
+
+	inline QRect FocusFrameSubrect(const StyleMetrics & metrics, const QStyleOptionViewItem & opt)
+	{
+		return metrics.GetSubrects(opt).focus;
+	}
+
 
 	/// возвращает horizontal text margin.
 	/// Qt вычисляет область текста с отступами справа и слева
@@ -97,6 +195,12 @@ namespace Delegates
 		return TextMargin(style);
 	}
 
+	/// возвращает horizontal text margin из закешированных метрик
+	inline int TextMargin(const StyleMetrics & metrics)
+	{
+		return metrics.GetTextMargin();
+	}
+
 	/// возвращает text margins. Qt вычисляет область текста с отступами справа и слева.
 	/// Note: по факту учитывается только PM_FocusFrameHMargin, но не PM_FocusFrameVMargin
 	/// 
@@ -128,6 +232,14 @@ namespace Delegates
 		return RemoveTextMargin(style, textRect);
 	}
 
+	/// убирает text margin из области полученной с помощью QtTools::Delegates::TextSubrect,
+	/// margin берется из закешированных метрик
+	inline void RemoveTextMargin(const StyleMetrics & metrics, QRect & textRect)
+	{
+		int padding = metrics.GetTextMargin();
+		textRect.adjust(padding, 0, -padding, 0);
+	}
+
 	/************************************************************************/
 	/*            DrawMethods                                               */
 	/************************************************************************/
@@ -145,4 +257,9 @@ namespace Delegates
 	/// рисует рамку фокуса
 	/// @Param opt как есть из метода paint, с обработкой по желанию
 	void DrawFocusFrame(QPainter * painter, const QRect & focusRect, const QStyleOptionViewItem & opt);
+
+	/// аналогичны функциям выше, но стиль берется из закешированных метрик
+	void DrawBackground(QPainter * painter, const StyleMetrics & metrics, const QStyleOptionViewItem & opt);
+	void DrawCheckmark(QPainter * painter, const StyleMetrics & metrics, const QRect & checkRect, const QStyleOptionViewItem & opt);
+	void DrawFocusFrame(QPainter * painter, const StyleMetrics & metrics, const QRect & focusRect, const QStyleOptionViewItem & opt);
 }}
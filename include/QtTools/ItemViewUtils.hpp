@@ -13,6 +13,33 @@ QT_END_NAMESPACE
 
 namespace QtTools
 {
+	/// Стратегия измерения содержимого для больших моделей,
+	/// используется ResizeColumnsToContents, ItemViewWidthHint/ItemViewHeightHint.
+	/// Если строк не больше exactLimit - измеряются все строки.
+	/// Иначе измеряются видимые строки и стратифицированная выборка из sampleSize строк:
+	/// модель делится на sampleSize равных интервалов и из каждого берется по одной строке.
+	struct ItemViewSampling
+	{
+		/// до какого количества строк выполняется полное измерение
+		int exactLimit = 10000;
+		/// размер выборки для больших моделей
+		int sampleSize = 1000;
+
+		/// только для ResizeColumnsToContents(QTableView *):
+		/// после выборки оставшиеся строки измеряются постепенно, порциями по sliceSize строк за итерацию event loop,
+		/// колонки расширяются по мере нахождения более широких значений.
+		/// Изменение layout модели во время измерения не начинает его заново: найденные максимумы сохраняются,
+		/// строки, переместившиеся в уже измеренную часть, досматриваются ограниченным числом повторных проходов.
+		/// По завершении измерения измеритель отключается от модели и удаляется
+		bool progressive = false;
+		int sliceSize = 2000;
+		/// только вместе с progressive: после завершения измерения продолжать отслеживать изменения модели
+		/// (вставки строк, изменения данных), поддерживая максимумы колонок актуальными до сброса/перестройки модели.
+		/// Максимумы используются последующими вызовами ResizeColumnsToContents вместо выборки.
+		/// Для часто обновляемых таблиц это постоянная дополнительная работа на каждое изменение
+		bool trackChanges = false;
+	};
+
 	/// вычисляет высоту строки для заданного view,
 	/// из view берется шрифт, и другие необходимые параметры.
 	/// при этом модель не используется.
@@ -35,7 +62,9 @@ namespace QtTools
 	/// * + frameWidth
 	/// * + verticalHeader()->width() if applicable and visible
 	/// * + verticalScrollBar width if withScrollBar
-	int ItemViewWidthHint(const QListView  * view, bool withScrollBar);
+	/// для больших моделей QListView измеряется согласно sampling(смотри ItemViewSampling),
+	/// для QTableView/QTreeView ширина берется из header и не зависит от количества строк
+	int ItemViewWidthHint(const QListView  * view, bool withScrollBar, const ItemViewSampling & sampling = {});
 	int ItemViewWidthHint(const QTableView * view, bool withScrollBar);
 	int ItemViewWidthHint(const QTreeView  * view, bool withScrollBar);
 
@@ -44,9 +73,11 @@ namespace QtTools
 	/// * + frameWidth
 	/// * + horizontalHeader()->width() if applicable and visible
 	/// * + horizontalScrollBar width if withScrollBar
-	int ItemViewHeightHint(const QListView  * view, bool withScrollBar);
+	/// для больших моделей QListView/QTreeView высота экстраполируется по выборке(смотри ItemViewSampling),
+	/// для QTableView высота берется из vertical header за O(1)
+	int ItemViewHeightHint(const QListView  * view, bool withScrollBar, const ItemViewSampling & sampling = {});
 	int ItemViewHeightHint(const QTableView * view, bool withScrollBar);
-	int ItemViewHeightHint(const QTreeView  * view, bool withScrollBar);
+	int ItemViewHeightHint(const QTreeView  * view, bool withScrollBar, const ItemViewSampling & sampling = {});
 
 	/// вычисляет желаемые размеры QTableView/QListView/QTreeView:
 	/// но не превышает нижнего/верхнего пределов
@@ -68,7 +99,8 @@ namespace QtTools
 	/// на данный момент это contentsMargins
 	QSize LayoutAdditionalSize(const QLayout * layout);
 
-	/// вычисляет и меняет размер колонок под содержимое
-	void ResizeColumnsToContents(QTableView * tableView);
-	void ResizeColumnsToContents(QTreeView * treeView);
+	/// вычисляет и меняет размер колонок под содержимое.
+	/// для больших моделей измеряются видимые строки и выборка(смотри ItemViewSampling)
+	void ResizeColumnsToContents(QTableView * tableView, const ItemViewSampling & sampling = {});
+	void ResizeColumnsToContents(QTreeView * treeView, const ItemViewSampling & sampling = {});
 }
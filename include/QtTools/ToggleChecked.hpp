@@ -1,15 +1,160 @@
 #pragma once
 #include <iterator>
+#include <vector>
+#include <tuple>
+#include <algorithm>
 #include <QtCore/QModelIndex>
 #include <QtCore/QAbstractItemModel>
+#include <QtCore/QAbstractProxyModel>
+#include <QtCore/QSignalBlocker>
 
 namespace QtTools
 {
-	/// подсчитывает кол-во элементов из набора индексов в заданном состоянии
+	/// Интерфейс массовой работы с Qt::CheckStateRole.
+	/// Модель может реализовать его(дополнительным базовым классом),
+	/// тогда CheckedCount/ToggleChecked будут работать с диапазонами строк за один вызов, а не поэлементно
+	class CheckStateBulkAccess
+	{
+	public:
+		/// подсчитывает кол-во строк [first, last] колонки column с родителем parent в состоянии state
+		virtual int CheckStateCount(const QModelIndex & parent, int column, int first, int last, Qt::CheckState state) const = 0;
+		/// выставляет состояние state строкам [first, last] колонки column с родителем parent.
+		/// Реализация сама уведомляет представления, желательно одним dataChanged на диапазон
+		virtual bool SetCheckStateRange(const QModelIndex & parent, int column, int first, int last, Qt::CheckState state) = 0;
+
+	protected:
+		~CheckStateBulkAccess() = default;
+	};
+
+	/// способ изменения состояния для моделей, не реализующих CheckStateBulkAccess
+	enum class CheckStateFallback
+	{
+		/// setData поэлементно, все сигналы модели сохраняются
+		PerIndex,
+		/// setData поэлементно с заблокированными сигналами модели, затем один dataChanged на непрерывный диапазон строк.
+		/// Прочие сигналы модели теряются(itemChanged, check state auto tristate родителей QStandardItemModel и т.п.),
+		/// поэтому используется только по явному запросу. Proxy модели всегда обновляются поэлементно
+		BlockedRange,
+	};
+
+	namespace ToggleCheckedDetail
+	{
+		/// непрерывный диапазон строк [first, last] одной колонки одного родителя одной модели
+		struct IndexRange
+		{
+			QAbstractItemModel * model;
+			QModelIndex parent;
+			int column, first, last;
+		};
+
+		/// реализует ли модель индексов CheckStateBulkAccess, проверяется модель первого индекса
+		template <class IndexList>
+		bool HasBulkAccess(const IndexList & indxes)
+		{
+			auto first = std::begin(indxes);
+			if (first == std::end(indxes)) return false;
+
+			return dynamic_cast<const CheckStateBulkAccess *>(first->model()) != nullptr;
+		}
+
+		/// группирует индексы по модели, родителю и колонке, и разбивает на непрерывные диапазоны строк
+		template <class IndexList>
+		std::vector<IndexRange> GroupRanges(const IndexList & indxes)
+		{
+			// parent вычисляется один раз на индекс, а не при каждом сравнении
+			std::vector<IndexRange> sorted;
+			sorted.reserve(indxes.size());
+			for (const auto & idx : indxes)
+			{
+				if (not idx.isValid()) continue;
+				auto * model = const_cast<QAbstractItemModel *>(idx.model());
+				sorted.push_back({model, idx.parent(), idx.column(), idx.row(), idx.row()});
+			}
+
+			auto key = [](const IndexRange & r) { return std::tie(r.model, r.parent, r.column, r.first); };
+			std::sort(sorted.begin(), sorted.end(), [&key](auto & r1, auto & r2) { return key(r1) < key(r2); });
+
+			std::vector<IndexRange> ranges;
+			for (auto & item : sorted)
+			{
+				if (not ranges.empty())
+				{
+					auto & last = ranges.back();
+					if (last.model == item.model and last.column == item.column and last.parent == item.parent and last.last + 1 >= item.first)
+					{
+						last.last = std::max(last.last, item.first);
+						continue;
+					}
+				}
+
+				ranges.push_back(std::move(item));
+			}
+
+			return ranges;
+		}
+
+		inline int CountRange(const IndexRange & range, Qt::CheckState state)
+		{
+			if (auto * bulk = dynamic_cast<const CheckStateBulkAccess *>(range.model))
+				return bulk->CheckStateCount(range.parent, range.column, range.first, range.last, state);
+
+			int count = 0;
+			for (int row = range.first; row <= range.last; ++row)
+			{
+				auto idx = range.model->index(row, range.column, range.parent);
+				auto st = static_cast<Qt::CheckState>(range.model->data(idx, Qt::CheckStateRole).toInt());
+				if (st == state) ++count;
+			}
+
+			return count;
+		}
+
+		inline void SetRange(const IndexRange & range, Qt::CheckState state, CheckStateFallback fallback)
+		{
+			auto * model = range.model;
+			if (auto * bulk = dynamic_cast<CheckStateBulkAccess *>(model))
+			{
+				if (bulk->SetCheckStateRange(range.parent, range.column, range.first, range.last, state))
+					return;
+			}
+
+			// proxy model translates source signals into its own(layout changes on sorting/filtering),
+			// those must not be blocked
+			if (fallback == CheckStateFallback::PerIndex or qobject_cast<QAbstractProxyModel *>(model))
+			{
+				for (int row = range.first; row <= range.last; ++row)
+					model->setData(model->index(row, range.column, range.parent), state, Qt::CheckStateRole);
+
+				return;
+			}
+
+			{
+				QSignalBlocker blocker(model);
+				for (int row = range.first; row <= range.last; ++row)
+					model->setData(model->index(row, range.column, range.parent), state, Qt::CheckStateRole);
+			}
+
+			auto topLeft = model->index(range.first, range.column, range.parent);
+			auto bottomRight = model->index(range.last, range.column, range.parent);
+			Q_EMIT model->dataChanged(topLeft, bottomRight, {Qt::CheckStateRole});
+		}
+	}
+
+	/// подсчитывает кол-во элементов из набора индексов в заданном состоянии.
+	/// Если модель реализует CheckStateBulkAccess - индексы группируются в непрерывные диапазоны строк
+	/// и подсчитываются им, иначе состояние читается поэлементно
 	template <class IndexList>
 	int CheckedCount(const IndexList & indxes, Qt::CheckState state = Qt::Checked)
 	{
 		int checkedCount = 0;
+		if (ToggleCheckedDetail::HasBulkAccess(indxes))
+		{
+			for (const auto & range : ToggleCheckedDetail::GroupRanges(indxes))
+				checkedCount += ToggleCheckedDetail::CountRange(range, state);
+
+			return checkedCount;
+		}
+
 		for (const auto & idx : indxes)
 		{
 			auto st = static_cast<Qt::CheckState>(idx.data(Qt::CheckStateRole).toInt());
@@ -22,20 +167,34 @@ namespace QtTools
 	/// Меняет состояние элементов из набора индексов indxes.
 	///   Если все элементы checked или unckecked - переводит все в противоположенное состояние
 	///   приводит все элементы к большей группе
-	///   
+	///
+	/// Если модель реализует CheckStateBulkAccess или запрошен CheckStateFallback::BlockedRange -
+	/// индексы группируются в непрерывные диапазоны строк, и каждый диапазон изменяется целиком,
+	/// иначе setData вызывается поэлементно
+	///
 	/// @Param indxes набор элементов
 	/// @Param checkedCount кол-во выбранных элементов
+	/// @Param fallback способ изменения для моделей без CheckStateBulkAccess
 	template <class IndexList>
-	void ToggleChecked(IndexList & indxes, int checkedCount)
+	void ToggleChecked(IndexList & indxes, int checkedCount, CheckStateFallback fallback = CheckStateFallback::PerIndex)
 	{
 		auto sz = indxes.size();
 		bool checked = checkedCount == 0 || (checkedCount != sz && checkedCount >= sz / 2);
+		auto state = checked ? Qt::Checked : Qt::Unchecked;
+
+		if (fallback == CheckStateFallback::BlockedRange or ToggleCheckedDetail::HasBulkAccess(indxes))
+		{
+			for (const auto & range : ToggleCheckedDetail::GroupRanges(indxes))
+				ToggleCheckedDetail::SetRange(range, state, fallback);
+
+			return;
+		}
 
 		typedef typename IndexList::value_type value_type;
 		for (value_type & idx : indxes)
 		{
 			auto * model = const_cast<QAbstractItemModel *>(idx.model());
-			model->setData(idx, checked ? Qt::Checked : Qt::Unchecked, Qt::CheckStateRole);
+			model->setData(idx, state, Qt::CheckStateRole);
 		}
 	}
 
@@ -44,9 +203,10 @@ namespace QtTools
 	///   приводит все элементы к большей группе
 	///
 	/// @Param indxes набор элементов
+	/// @Param fallback способ изменения для моделей без CheckStateBulkAccess
 	template <class IndexList>
-	inline void ToggleChecked(IndexList & indxes)
+	inline void ToggleChecked(IndexList & indxes, CheckStateFallback fallback = CheckStateFallback::PerIndex)
 	{
-		ToggleChecked(indxes, CheckedCount(indxes));
+		ToggleChecked(indxes, CheckedCount(indxes), fallback);
 	}
 }
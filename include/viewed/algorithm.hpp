@@ -213,41 +213,96 @@ namespace viewed
 	}
 
 
-	/// emits qt signal model->dataChanged about changed rows. Changed rows are defined by indexes stored in [first; last)
-	template <class SinglePassIterator>
-	void emit_changed(AbstractItemModel * model, SinglePassIterator first, SinglePassIterator last)
+	/// describes how changed rows are coalesced into qt dataChanged signals by emit_changed helpers.
+	/// Views handle each dataChanged separately, and for big models repainting some unchanged rows
+	/// is usually much cheaper than handling a lot of small dataChanged signals.
+	struct emit_changed_policy
+	{
+		/// changed rows separated by no more than max_gap unchanged rows are reported as one range,
+		/// 0 - only strictly consecutive rows are merged
+		int max_gap = 0;
+		/// if changed rows make up at least whole_ratio of all rows - one dataChanged for all rows is emitted,
+		/// values > 1 disable this
+		double whole_ratio = 2.0;
+	};
+
+	/// coalesces changed rows from [first; last) into ranges according to policy and calls emit(top, bottom) for each one.
+	/// Changed rows must be sorted in ascending order, nrows - number of rows in model(or parent for tree models)
+	template <class RandomAccessIterator, class Emitter>
+	void coalesce_changed(RandomAccessIterator first, RandomAccessIterator last, int nrows,
+	                      const emit_changed_policy & policy, Emitter && emit)
 	{
 		if (first == last) return;
 
-		int ncols = model->columnCount(AbstractItemModel::invalid_index);
+		if (nrows > 0 and last - first >= policy.whole_ratio * nrows)
+			return static_cast<void>(emit(0, nrows - 1));
 
+		int step = std::max(policy.max_gap, 0) + 1;
 		for (; first != last; ++first)
 		{
 			// lower index on top, higher on bottom
 			int top, bottom;
 			top = bottom = *first;
 
-			// try to find the sequences with step of 1, for example: ..., 4, 5, 6, ...
-			for (++first; first != last and *first - bottom == 1; ++first, ++bottom)
-				continue;
+			// try to find the sequences with step no more than max_gap + 1, for example: ..., 4, 5, 6, ... or ..., 4, 6, 8, ...
+			for (++first; first != last and *first > bottom and *first - bottom <= step; ++first)
+				bottom = *first;
 
 			--first;
+			emit(top, bottom);
+		}
+	}
+
+	/// emits qt signal model->dataChanged about changed rows. Changed rows are defined by indexes stored in [first; last),
+	/// rows are coalesced according to policy, see coalesce_changed
+	template <class RandomAccessIterator>
+	void emit_changed(AbstractItemModel * model, RandomAccessIterator first, RandomAccessIterator last,
+	                  const emit_changed_policy & policy = {})
+	{
+		if (first == last) return;
 
+		int ncols = model->columnCount(AbstractItemModel::invalid_index);
+		int nrows = model->rowCount(AbstractItemModel::invalid_index);
+
+		coalesce_changed(first, last, nrows, policy, [model, ncols](int top, int bottom)
+		{
 			auto top_left = model->index(top, 0, AbstractItemModel::invalid_index);
 			auto bottom_right = model->index(bottom, ncols - 1, AbstractItemModel::invalid_index);
 			Q_EMIT model->dataChanged(top_left, bottom_right, AbstractItemModel::all_roles);
-		}
+		});
 	}
 
-	/// changes persistent indexes via get_model->changePersistentIndex.
+	/// narrows index array [first; last), where range[oldIdx - offset] => newIdx, to subrange affected by permutation:
+	/// leading and trailing elements with range[oldIdx - offset] == oldIdx are skipped.
+	/// returns offset of resulting subrange, if nothing is moved - returned range is empty
+	template <class RandomAccessIterator>
+	int trim_index_array(RandomAccessIterator & first, RandomAccessIterator & last, int offset)
+	{
+		for (; first != last and *first == offset; ++first, ++offset)
+			continue;
+
+		for (int back = offset + static_cast<int>(last - first) - 1; first != last and last[-1] == back; --last, --back)
+			continue;
+
+		return offset;
+	}
+
+	/// changes persistent indexes via get_model->changePersistentIndexList.
 	/// [first; last) - range where range[oldIdx - offset] => newIdx.
 	/// if newIdx < 0 - index should be removed(changed on invalid, qt supports it)
-	template <class SinglePassIterator>
-	void change_indexes(AbstractItemModel * model, SinglePassIterator first, SinglePassIterator last, int offset)
+	/// Only indexes actually moved by permutation are changed, if nothing is moved - persistent indexes are not touched at all
+	template <class RandomAccessIterator>
+	void change_indexes(AbstractItemModel * model, RandomAccessIterator first, RandomAccessIterator last, int offset)
 	{
-		auto size = last - first;
+		offset = trim_index_array(first, last, offset);
+		if (first == last) return;
 
+		auto size = last - first;
 		auto list = model->persistentIndexList();
+		QModelIndexList from, to;
+		from.reserve(list.size());
+		to.reserve(list.size());
+
 		for (const auto & idx : list)
 		{
 			if (!idx.isValid()) continue;
@@ -255,11 +310,16 @@ namespace viewed
 			auto row = idx.row();
 			auto col = idx.column();
 
-			if (row < offset) continue;
+			if (row < offset or row - offset >= size) continue;
+
+			auto newRow = first[row - offset];
+			if (newRow == row) continue;
 
-			assert(row < size); (void)size;
-			auto newIdx = model->index(first[row - offset], col);
-			model->changePersistentIndex(idx, newIdx);
+			from.append(idx);
+			to.append(model->index(newRow, col));
 		}
+
+		if (not from.isEmpty())
+			model->changePersistentIndexList(from, to);
 	}
 }
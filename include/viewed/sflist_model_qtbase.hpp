@@ -92,12 +92,16 @@ namespace viewed
 		sort_pred_type m_sort_pred;
 		filter_pred_type m_filter_pred;
 
+		/// how changed rows are coalesced into dataChanged signals by emit_changed, derived classes can tune it
+		emit_changed_policy m_emit_changed_policy;
+
 	protected:
 		/// acquires pointer to qt model, normally you would inherit both QAbstractItemModel and this class.
 		/// default implementation uses dynamic_cast
 		virtual model_type * get_model();
 		/// emits qt signal model->dataChanged about changed rows. Changed rows are defined by [first; last)
-		/// default implantation just calls get_model->dataChanged(index(row, 0), index(row, model->columnCount)
+		/// default implantation just calls get_model->dataChanged(index(row, 0), index(row, model->columnCount),
+		/// coalescing rows according to m_emit_changed_policy
 		virtual void emit_changed(int_vector::const_iterator first, int_vector::const_iterator last);
 		/// changes persistent indexes via get_model->changePersistentIndex.
 		/// [first; last) - range where range[oldIdx - offset] => newIdx.
@@ -223,7 +227,7 @@ namespace viewed
 	void sflist_model_qtbase<Type, Sorter, Filter>::emit_changed(int_vector::const_iterator first, int_vector::const_iterator last)
 	{
 		auto * model = get_model();
-		viewed::emit_changed(model, first, last);
+		viewed::emit_changed(model, first, last, m_emit_changed_policy);
 	}
 
 	template <class Type, class Sorter, class Filter>
@@ -3,6 +3,8 @@
 #include <vector>
 #include <tuple>
 #include <algorithm>
+#include <string>
+#include <string_view>
 
 #include <ext/config.hpp>
 #include <ext/utility.hpp>
@@ -45,6 +47,22 @@
 
 namespace viewed
 {
+	/// default key hasher for sfset_model_qtbase, same as std::hash<Key>
+	template <class Key>
+	struct sfset_key_hash : std::hash<Key> {};
+
+	/// string keys are hashed via std::basic_string_view, this makes hasher transparent:
+	/// lookup by std::string_view or const char * does not construct temporary key.
+	/// Standard guarantees std::hash<std::string>(str) == std::hash<std::string_view>(str)
+	template <class Char, class CharTraits, class Allocator>
+	struct sfset_key_hash<std::basic_string<Char, CharTraits, Allocator>>
+	{
+		using is_transparent = void;
+		using string_view_type = std::basic_string_view<Char, CharTraits>;
+
+		std::size_t operator()(string_view_type str) const noexcept { return std::hash<string_view_type>()(str); }
+	};
+
 	/// default sfset_model_qtbase traits
 	template <class Type, class KeyExtractor, class Sorter, class Filter>
 	struct sfset_model_traits
@@ -53,7 +71,7 @@ namespace viewed
 		using key_type = std::decay_t<std::invoke_result_t<KeyExtractor, const value_type &>>;
 
 		using key_extractor_type = KeyExtractor;
-		using key_hash_type      = std::hash<key_type>;
+		using key_hash_type      = sfset_key_hash<key_type>;
 		using key_equal_to_type  = std::equal_to<>;
 		using key_less_type      = std::less<>;
 
@@ -95,7 +113,8 @@ namespace viewed
 	///   key_extractor_type  - key extractor functor: usually something like: ... { return val.key; }
 	///   key_equal_to_type   - predicate used to compare key for equality, typically std::equal_to<>
 	///   key_less_type       - predicate used to compare key for less, typically std::less<>
-	///   key_hash_type       - functor used to calculate hash from key, typically std::hash<key_type>
+	///   key_hash_type       - functor used to calculate hash from key, typically std::hash<key_type> or sfset_key_hash<key_type>,
+	///                         if it's invocable with some other type - that type can be used as compatible key for lookup
 	///
 	///   using sort_pred_type = ...
 	///   using filter_pred_type = ...
@@ -199,6 +218,12 @@ namespace viewed
 	protected:
 		static constexpr auto make_ref = [](auto * ptr) { return std::ref(*ptr); };
 
+		/// CompatibleKey can be used for lookup either when it's convertible to key_type,
+		/// or directly by heterogeneous lookup, when key_hash_type can hash it
+		template <class CompatibleKey>
+		static constexpr bool is_compatible_key_v =
+			std::is_convertible_v<CompatibleKey, key_type> or std::is_invocable_v<const key_hash_type &, const CompatibleKey &>;
+
 	protected:
 		value_container m_store;
 		size_type m_nvisible = 0;
@@ -206,12 +231,16 @@ namespace viewed
 		sort_pred_type m_sort_pred;
 		filter_pred_type m_filter_pred;
 
+		/// how changed rows are coalesced into dataChanged signals by emit_changed, derived classes can tune it
+		emit_changed_policy m_emit_changed_policy;
+
 	protected:
 		/// acquires pointer to qt model, normally you would inherit both QAbstractItemModel and this class.
 		/// default implementation uses dynamic_cast
 		virtual model_type * get_model();
 		/// emits qt signal model->dataChanged about changed rows. Changed rows are defined by [first; last)
-		/// default implantation just calls get_model->dataChanged(index(row, 0), index(row, model->columnCount)
+		/// default implantation just calls get_model->dataChanged(index(row, 0), index(row, model->columnCount),
+		/// coalescing rows according to m_emit_changed_policy
 		virtual void emit_changed(int_vector::const_iterator first, int_vector::const_iterator last);
 		/// changes persistent indexes via get_model->changePersistentIndex.
 		/// [first; last) - range where range[oldIdx - offset] => newIdx.
@@ -267,6 +296,12 @@ namespace viewed
 		/// does not do actual erasing, but rotates elements that should be removed at the end of ctx.container
 		virtual void rearrange_and_notify(upsert_context & ctx);
 
+		/// erases elements at positions [first; last) from m_store, positions must be sorted and unique.
+		/// Compacts m_store in one pass, if erased visible elements form one contiguous range -
+		/// emits qt beginRemoveRows/endRemoveRows, otherwise layoutAboutToBeChanged/layoutChanged(..., NoLayoutChangeHint).
+		/// Erasing only shadow elements does not emit any qt signals
+		virtual void erase_and_notify(int_vector::const_iterator first, int_vector::const_iterator last);
+
 	public:
 		/// container interface
 		const_iterator begin()  const noexcept { return m_store.begin(); }
@@ -355,7 +390,8 @@ namespace viewed
 		/// erase element by key
 		template <class CompatibleKey>
 		size_type erase(const CompatibleKey & key);
-		/// erases elements specified by keys from [first; last)
+		/// erases elements specified by keys from [first; last).
+		/// positions of all keys are resolved first, than elements are erased all at once
 		template <class SinglePassIterator>
 		size_type erase(SinglePassIterator first, SinglePassIterator last);
 
@@ -379,7 +415,7 @@ namespace viewed
 	void sfset_model_qtbase<Types...>::emit_changed(int_vector::const_iterator first, int_vector::const_iterator last)
 	{
 		auto * model = get_model();
-		viewed::emit_changed(model, first, last);
+		viewed::emit_changed(model, first, last, m_emit_changed_policy);
 	}
 
 	template <class ... Types>
@@ -1058,7 +1094,7 @@ namespace viewed
 	template <class SinglePassIterator, class Modifier>
 	void sfset_model_qtbase<Types...>::modify(SinglePassIterator first, SinglePassIterator last, Modifier modifier)
 	{
-		static_assert(std::is_convertible_v<ext::iterator_value_t<SinglePassIterator>, key_type>);
+		static_assert(is_compatible_key_v<ext::iterator_value_t<SinglePassIterator>>);
 
 		if (first == last) return;
 
@@ -1148,7 +1184,7 @@ namespace viewed
 	template <class SinglePassIterator, class Modifier>
 	void sfset_model_qtbase<Types...>::rename(SinglePassIterator first, SinglePassIterator last, Modifier modifier)
 	{
-		static_assert(std::is_convertible_v<ext::iterator_value_t<SinglePassIterator>, key_type>);
+		static_assert(is_compatible_key_v<ext::iterator_value_t<SinglePassIterator>>);
 
 		if (first == last) return;
 
@@ -1225,12 +1261,17 @@ namespace viewed
 		auto & container = m_store;
 		auto & code_view = container.template get<by_code>();
 		auto & seq_view  = container.template get<by_seq>();
-		auto seq_ptr_view = seq_view | ext::outdirected;
 
 		auto it = code_view.find(key);
 		if (it == code_view.end()) return 0;
 
 		int pos = container.template project<by_seq>(it) - seq_view.begin();
+		if (static_cast<size_type>(pos) >= m_nvisible)
+		{
+			// shadow element, not visible to qt
+			code_view.erase(it);
+			return 1;
+		}
 
 		auto * model = get_model();
 		model->beginRemoveRows(model_type::invalid_index, pos, pos);
@@ -1245,48 +1286,93 @@ namespace viewed
 	template <class SinglePassIterator>
 	auto sfset_model_qtbase<Types...>::erase(SinglePassIterator first, SinglePassIterator last) -> size_type
 	{
-		static_assert(std::is_convertible_v<ext::iterator_value_t<SinglePassIterator>, key_type>);
+		static_assert(is_compatible_key_v<ext::iterator_value_t<SinglePassIterator>>);
 
 		if (first == last) return 0;
 
 		auto & container = m_store;
 		auto & code_view = container.template get<by_code>();
 		auto & seq_view  = container.template get<by_seq>();
+
+		int_vector removed;
+		ext::try_reserve(removed, first, last);
+
+		// resolve positions of all keys in one pass, keys are looked up as is - without constructing key_type
+		for (; first != last; ++first)
+		{
+			auto it = code_view.find(*first);
+			if (it == code_view.end()) continue;
+
+			int pos = container.template project<by_seq>(it) - seq_view.begin();
+			removed.push_back(pos);
+		}
+
+		// same key can be given more than once
+		std::sort(removed.begin(), removed.end());
+		removed.erase(std::unique(removed.begin(), removed.end()), removed.end());
+
+		erase_and_notify(removed.begin(), removed.end());
+		return removed.size();
+	}
+
+	template <class ... Types>
+	void sfset_model_qtbase<Types...>::erase_and_notify(int_vector::const_iterator first, int_vector::const_iterator last)
+	{
+		if (first == last) return;
+
+		auto & container = m_store;
+		auto & seq_view  = container.template get<by_seq>();
 		auto seq_ptr_view = seq_view | ext::outdirected;
 
-		value_ptr_vector vptr_array;
-		int_vector index_array, affected_indexes;
-		affected_indexes.resize(container.size());
-		vptr_array.reserve(container.size());
+		int nvisible = m_nvisible;
+		int nremoved = last - first;
 
-		upsert_context ctx;
-		ctx.size         = seq_view.size();
-		ctx.nvisible_ptr = &m_nvisible;
-		ctx.container    = &container;
-		ctx.index_array  = &index_array;
-		ctx.vptr_array   = &vptr_array;
+		// [first; vlast) - positions of visible elements, [vlast; last) - positions of shadow elements
+		auto vlast = std::lower_bound(first, last, nvisible);
+		int nvisible_removed = vlast - first;
+		// positions are sorted and unique - they are contiguous if distance between first and last equals their count
+		bool contiguous = nvisible_removed == 0 or *(vlast - 1) - *first + 1 == nvisible_removed;
 
-		auto & removed_first = ctx.removed_first = affected_indexes.end();
-		auto & removed_last  = ctx.removed_last  = affected_indexes.end();
+		// Emitting beginRemoveRows/endRemoveRows for each contiguous run of visible elements would require
+		// m_store to be in consistent state after each endRemoveRows, meaning erasing each run separately -
+		// and that is O(n) per run. Instead we compact m_store once and, if there are several runs, notify via layoutChanged
+		auto * model = get_model();
+		if (nvisible_removed == 0)
+			; // only shadow elements are removed, they are not visible to qt
+		else if (contiguous)
+			model->beginRemoveRows(model_type::invalid_index, *first, *(vlast - 1));
+		else
+			Q_EMIT model->layoutAboutToBeChanged(model_type::empty_model_list, model_type::NoLayoutChangeHint);
 
-		auto & changed_first = ctx.changed_first = affected_indexes.begin();
-		auto & changed_last  = ctx.changed_last  = affected_indexes.begin();
+		value_ptr_vector valptr_vector;
+		valptr_vector.assign(seq_ptr_view.begin(), seq_ptr_view.end());
 
+		// boost::multi_index_container::rearrange expects all elements,
+		// so removed ones are gathered at the end, and after rearranging they are erased all at once
+		value_ptr_vector removed_ptrs;
+		removed_ptrs.reserve(nremoved);
+		for (auto it = first; it != last; ++it)
+			removed_ptrs.push_back(valptr_vector[*it]);
 
-		for (; first != last; ++first)
-		{
-			auto && key = *first;
+		auto vfirst = valptr_vector.begin();
+		auto vlast_ptr = viewed::remove_indexes(vfirst, valptr_vector.end(), first, last);
+		std::copy(removed_ptrs.begin(), removed_ptrs.end(), vlast_ptr);
 
-			auto it = code_view.find(key);
-			if (it == code_view.end()) continue;
+		seq_view.rearrange(boost::make_transform_iterator(vfirst, make_ref));
+		seq_view.resize(seq_view.size() - nremoved);
+		m_nvisible = nvisible - nvisible_removed;
 
-			int pos = container.template project<by_seq>(it) - seq_view.begin();
-			*--removed_first = pos;
-		 }
+		if (nvisible_removed == 0)
+			return;
 
-		auto removed = removed_last - removed_first;
-		rearrange_and_notify(ctx);
-		return removed;
+		if (contiguous)
+			return model->endRemoveRows();
+
+		// recalculate qt persistent indexes and notify any clients
+		auto index_map = viewed::build_relloc_map(first, vlast, nvisible);
+		change_indexes(index_map.begin(), index_map.end(), 0);
+
+		Q_EMIT model->layoutChanged(model_type::empty_model_list, model_type::NoLayoutChangeHint);
 	}
 
 	template <class ... Types>
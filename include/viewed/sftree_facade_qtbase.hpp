@@ -360,6 +360,9 @@ namespace viewed
 		sort_pred_type   m_sort_pred;
 		filter_pred_type m_filter_pred;
 
+		/// how changed rows are coalesced into dataChanged signals by emit_changed, derived classes can tune it
+		emit_changed_policy m_emit_changed_policy;
+
 	protected:
 		static ivalue_container create_container(const self_type * self);
 		static ivalue_container create_container(ext::noinit_type);
@@ -398,7 +401,8 @@ namespace viewed
 
 	protected:
 		/// emits qt signal this->dataChanged about changed rows. Changed rows are defined by [first; last)
-		/// default implantation just calls this->dataChanged(index(row, 0, parent), index(row, this->columnCount, parent))
+		/// default implantation just calls this->dataChanged(index(row, 0, parent), index(row, this->columnCount, parent)),
+		/// coalescing rows according to m_emit_changed_policy
 		virtual void emit_changed(QModelIndex parent, int_vector::const_iterator first, int_vector::const_iterator last);
 		/// changes persistent indexes via this->changePersistentIndex.
 		/// [first; last) - range where range[oldIdx - offset] => newIdx.
@@ -880,22 +884,14 @@ namespace viewed
 
 		auto * that = static_cast<const QAbstractItemModel *>(this);
 		int ncols = that->columnCount(parent);
-		for (; first != last; ++first)
-		{
-			// lower index on top, higher on bottom
-			int top, bottom;
-			top = bottom = *first;
-
-			// try to find the sequences with step of 1, for example: ..., 4, 5, 6, ...
-			for (++first; first != last and *first - bottom == 1; ++first, ++bottom)
-				continue;
-
-			--first;
+		int nrows = that->rowCount(parent);
 
+		viewed::coalesce_changed(first, last, nrows, m_emit_changed_policy, [this, &parent, ncols](int top, int bottom)
+		{
 			auto top_left = this->index(top, 0, parent);
 			auto bottom_right = this->index(bottom, ncols - 1, parent);
 			this->dataChanged(top_left, bottom_right, model_helper::all_roles);
-		}
+		});
 	}
 
 	template <class Traits, class ModelBase>
@@ -917,7 +913,10 @@ namespace viewed
 			if (row < offset) continue;
 
 			assert(row < size); (void)size;
-			auto newIdx = create_index(first[row - offset], col, pageptr);
+			auto newRow = first[row - offset];
+			if (newRow == row) continue; // not moved
+
+			auto newIdx = create_index(newRow, col, pageptr);
 			this->changePersistentIndex(idx, newIdx);
 		}
 	}
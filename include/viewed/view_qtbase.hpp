@@ -40,6 +40,10 @@ namespace viewed
 		typedef std::vector<int> int_vector;
 		typedef viewed::AbstractItemModel model_type;
 
+	protected:
+		/// how changed rows are coalesced into dataChanged signals by emit_changed, derived classes can tune it
+		viewed::emit_changed_policy m_emit_changed_policy;
+
 	public:
 		/// reinitializes view and notifies anyone via qt beginResetModel/endResetModel signals
 		/// default implementation emits beginResetModel, calls reinit_view, emits endResetModel
@@ -50,7 +54,8 @@ namespace viewed
 		/// default implementation uses dynamic_cast
 		virtual model_type * get_model();
 		/// emits qt signal model->dataChanged about changed rows. Changred rows are defined by [first; last)
-		/// default implantation just calls get_model->dataChanged(index(row, 0), inex(row, model->columnCount)
+		/// default implantation just calls get_model->dataChanged(index(row, 0), inex(row, model->columnCount),
+		/// coalescing rows according to m_emit_changed_policy
 		virtual void emit_changed(int_vector::const_iterator first, int_vector::const_iterator last);
 		/// changes persistent indexes via get_model->changePersistentIndex.
 		/// [first; last) - range where range[oldIdx - offset] => newIdx.
@@ -121,7 +126,7 @@ namespace viewed
 	void view_qtbase<Container>::emit_changed(int_vector::const_iterator first, int_vector::const_iterator last)
 	{
 		auto * model = get_model();
-		viewed::emit_changed(model, first, last);
+		viewed::emit_changed(model, first, last, m_emit_changed_policy);
 	}
 
 	template <class Container>
@@ -1,4 +1,5 @@
 #include <cassert>
+#include <cmath>
 #include <algorithm> // for replace_if
 
 #include <QtGui/QPainter>
@@ -133,6 +134,145 @@ namespace Delegates
 			}
 		}
 
+		void DrawElidedLine(QPainter * painter, const QRect & lineRect, const QTextLayout & layout, int elideIndex,
+		                    Qt::TextElideMode mode, const QVector<QTextLayout::FormatRange> & ellipsisFormats)
+		{
+			const QChar ellipsis(0x2026);
+			const QString & text = layout.text();
+			const QTextLine line = layout.lineAt(elideIndex);
+			const QTextOption & textOption = layout.textOption();
+			const bool rtl = textOption.textDirection() == Qt::RightToLeft;
+
+			// хвостовые пробельные символы(в том числе переводы строк) не рисуем
+			const int start = line.textStart();
+			int end = start + line.textLength();
+			while (end > start and text[end - 1].isSpace()) --end;
+
+			auto xpos = [&line](int pos) { return line.cursorToX(pos); };
+			auto advance = [&xpos](int from, int to) { return std::abs(xpos(to) - xpos(from)); };
+
+			// максимальная позиция p из [from, to], такая что advance(from, p) <= avail
+			auto fitForward = [&](int from, int to, qreal avail)
+			{
+				int lo = from, hi = to;
+				while (lo < hi)
+				{
+					int mid = lo + (hi - lo + 1) / 2;
+					if (advance(from, mid) <= avail) lo = mid;
+					else                             hi = mid - 1;
+				}
+
+				while (lo > from and not layout.isValidCursorPosition(lo)) --lo;
+				return lo;
+			};
+
+			// минимальная позиция p из [from, to], такая что advance(p, to) <= avail
+			auto fitBackward = [&](int from, int to, qreal avail)
+			{
+				int lo = from, hi = to;
+				while (lo < hi)
+				{
+					int mid = lo + (hi - lo) / 2;
+					if (advance(mid, to) <= avail) hi = mid;
+					else                           lo = mid + 1;
+				}
+
+				while (lo < to and not layout.isValidCursorPosition(lo)) ++lo;
+				return lo;
+			};
+
+			const qreal width = lineRect.width();
+			const qreal ellipsisWidth = mode == Qt::ElideNone ? 0 : painter->fontMetrics().width(ellipsis);
+			const qreal avail = std::max<qreal>(0, width - ellipsisWidth);
+
+			// видимые части: [start, headEnd) ... [tailStart, end), скрытый текст: [headEnd, tailStart) + все после линии
+			int headEnd = end, tailStart = end;
+			int hiddenStart, hiddenEnd;
+			switch (mode)
+			{
+				case Qt::ElideNone:
+				case Qt::ElideRight:
+				default:
+					headEnd = fitForward(start, end, avail);
+					hiddenStart = headEnd, hiddenEnd = text.length();
+					break;
+
+				case Qt::ElideLeft:
+					headEnd = start;
+					tailStart = fitBackward(start, end, avail);
+					hiddenStart = start, hiddenEnd = tailStart;
+					break;
+
+				case Qt::ElideMiddle:
+					headEnd = fitForward(start, end, avail / 2);
+					tailStart = fitBackward(headEnd, end, avail - advance(start, headEnd));
+					hiddenStart = headEnd, hiddenEnd = tailStart;
+					break;
+			}
+
+			struct piece { int from, to; qreal width; };
+			piece pieces[3] = {
+				{start, headEnd, advance(start, headEnd)},
+				{-1, -1, ellipsisWidth},
+				{tailStart, end, advance(tailStart, end)},
+			};
+
+			// справа налево части идут в обратном визуальном порядке
+			if (rtl) std::swap(pieces[0], pieces[2]);
+
+			const qreal totalWidth = pieces[0].width + pieces[1].width + pieces[2].width;
+			const auto align = (textOption.alignment() & Qt::AlignHorizontal_Mask) | Qt::AlignTop;
+			const QSize blockSize(static_cast<int>(std::ceil(totalWidth)), lineRect.height());
+			const QRect blockRect = QStyle::alignedRect(textOption.textDirection(), align, blockSize, lineRect);
+
+			painter->save();
+			painter->setClipRect(lineRect, Qt::IntersectClip);
+
+			qreal curx = blockRect.left();
+			const qreal top = lineRect.top();
+			for (const auto & p : pieces)
+			{
+				if (p.from < 0) // многоточие
+				{
+					if (p.width > 0)
+					{
+						QRectF ellipsisRect(curx, top, p.width, line.height());
+						auto found = std::find_if(ellipsisFormats.begin(), ellipsisFormats.end(), [hiddenStart, hiddenEnd](auto & fmt)
+						{
+							return fmt.start < hiddenEnd and fmt.start + fmt.length > hiddenStart;
+						});
+
+						painter->save();
+						if (found != ellipsisFormats.end())
+						{
+							const auto & fmt = found->format;
+							if (fmt.hasProperty(QTextFormat::BackgroundBrush))
+								painter->fillRect(ellipsisRect, fmt.background());
+							if (fmt.hasProperty(QTextFormat::ForegroundBrush))
+								painter->setPen(fmt.foreground().color());
+						}
+
+						painter->setFont(layout.font());
+						painter->drawText(QPointF(curx, top + line.ascent()), QString(ellipsis));
+						painter->restore();
+					}
+				}
+				else if (p.from < p.to)
+				{
+					// рисуем линию целиком, сдвинув так, что бы нужная часть попала в curx, и отсекаем все остальное
+					const qreal left = std::min(xpos(p.from), xpos(p.to));
+					painter->save();
+					painter->setClipRect(QRectF(curx, top, p.width, line.height()), Qt::IntersectClip);
+					line.draw(painter, {curx - left, top - line.y()});
+					painter->restore();
+				}
+
+				curx += p.width;
+			}
+
+			painter->restore();
+		}
+
 		QTextOption PrepareTextOption(const QStyleOptionViewItem & opt)
 		{
 			QTextOption textOption;
@@ -168,6 +308,122 @@ namespace Delegates
 
 	}
 
+	uint qHash(const StaticTextCache::Key & key, uint seed) noexcept
+	{
+		// qHash для QString/QFont находятся в глобальном пространстве имен и скрыты данной функцией
+		seed = ::qHash(key.text, seed);
+		return ::qHash(key.font, seed);
+	}
+
+	const QStaticText * StaticTextCache::Acquire(const QString & text, const QFont & font)
+	{
+		if (m_limit <= 0) return nullptr;
+
+		Key key {text, font};
+		auto found = m_index.find(key);
+		if (found != m_index.end())
+		{
+			auto it = *found;
+			m_items.splice(m_items.begin(), m_items, it);
+			return &it->second;
+		}
+
+		// текст встречен впервые - только запоминаем, в кеш попадет при повторе
+		const uint hash = qHash(key, 0);
+		if (not m_seen.contains(hash))
+		{
+			if (m_seen.size() >= m_limit) m_seen.clear();
+			m_seen.insert(hash);
+			return nullptr;
+		}
+
+		m_seen.remove(hash);
+		if (static_cast<int>(m_items.size()) >= m_limit)
+		{
+			m_index.remove(m_items.back().first);
+			m_items.pop_back();
+		}
+
+		QStaticText staticText(text);
+		staticText.setTextFormat(Qt::PlainText);
+		staticText.setPerformanceHint(QStaticText::AggressiveCaching);
+		staticText.prepare(QTransform(), font);
+
+		m_items.emplace_front(key, std::move(staticText));
+		m_index.insert(std::move(key), m_items.begin());
+		return &m_items.front().second;
+	}
+
+	void StaticTextCache::Clear()
+	{
+		m_index.clear();
+		m_items.clear();
+		m_seen.clear();
+	}
+
+	void StaticTextCache::SetLimit(int limit)
+	{
+		m_limit = limit;
+		while (static_cast<int>(m_items.size()) > std::max(limit, 0))
+		{
+			m_index.remove(m_items.back().first);
+			m_items.pop_back();
+		}
+	}
+
+	bool IsSingleLineText(const QString & text) noexcept
+	{
+		auto isBreak = [](QChar ch)
+		{
+			switch (ch.unicode())
+			{
+				case '\n':
+				case '\r':
+				case '\t':
+				case QChar::LineSeparator:
+				case QChar::ParagraphSeparator:
+					return true;
+
+				default:
+					return false;
+			}
+		};
+
+		return std::none_of(text.begin(), text.end(), isBreak);
+	}
+
+	bool DrawPlainText(QPainter * painter, const QString & text, const QRect & textRect, const QStyleOptionViewItem & opt,
+	                   StaticTextCache & cache)
+	{
+		if (not IsSingleLineText(text))
+			return false;
+
+		// не повторяющийся текст рисуется напрямую, без подготовки QStaticText
+		const QStaticText * staticText = cache.Acquire(text, opt.font);
+		QSizeF size;
+		if (staticText)
+			size = staticText->size();
+		else
+		{
+			const QFontMetricsF fm(opt.font, painter->device());
+			size = {fm.width(text), fm.height()};
+		}
+
+		if (size.width() > textRect.width() or size.height() > textRect.height())
+			return false;
+
+		auto * style = AccquireStyle(opt);
+		QSize alignSize(static_cast<int>(std::ceil(size.width())), static_cast<int>(std::ceil(size.height())));
+		auto drawRect = TextLayout::AlignedRect(style, opt, alignSize, textRect);
+
+		if (staticText)
+			painter->drawStaticText(drawRect.topLeft(), *staticText);
+		else
+			painter->drawText(drawRect, Qt::AlignLeft | Qt::AlignTop | Qt::TextSingleLine, text);
+
+		return true;
+	}
+
 	void DrawFormattedText(QPainter * painter, const QString & text, const QRect & textRect, const QStyleOptionViewItem & opt,
 	                       const QVector<QTextLayout::FormatRange> & additionalFormats)
 	{
@@ -194,19 +450,8 @@ namespace Delegates
 			// same as ElideLineRect(textLayout, elideIdx), but inplace
 			auto line = textLayout.lineAt(elideIdx);
 			drawRect.adjust(0, drawRect.height() - line.height(), 0, 0);
-
-			int elidePoint = line.textStart();
-			QString elidedText = text.mid(elidePoint);
-			auto fontMetrics = painter->fontMetrics();   // painter is already prepared
-			elidedText = ElideText(fontMetrics, elidedText, opt.textElideMode, drawRect.width());
-
-			QTextLayout elideLayout(elidedText, opt.font, painter->device());
-			elideLayout.setTextOption(textOption);
-			elideLayout.setFormats(ElideFormats(additionalFormats, elidePoint));
-			elideLayout.setCacheEnabled(true);
-			DoLayout(elideLayout, drawRect);
-			// обманываем, нам нужно что бы он нарисовал одну единственную линию
-			DrawLayout(painter, drawRect.topLeft(), elideLayout, 1);
+			// усекаем по уже размеченной линии, без повторной разметки
+			DrawElidedLine(painter, drawRect, textLayout, elideIdx, opt.textElideMode);
 		}
 	}
 }}
@@ -10,11 +10,16 @@ namespace Delegates
 	void FormattedItemDelegate::DrawText(QPainter * painter, QStyleOptionViewItem & opt) const
 	{
 		auto fmts = Format(opt, opt.index);
-		auto rect = TextSubrect(opt);
-		RemoveTextMargin(opt, rect);
+		const auto & metrics = Metrics(opt);
+		auto rect = TextSubrect(metrics, opt);
+		RemoveTextMargin(metrics, rect);
 
 		PreparePainter(painter, opt);
 		DrawEditingFrame(painter, rect, opt);
+		// без форматов - пробуем быстрый путь через QStaticText
+		if (fmts.isEmpty() and DrawPlainText(painter, opt.text, rect, opt, m_textCache))
+			return;
+
 		DrawFormattedText(painter, opt.text, rect, opt, fmts);
 	}
 
@@ -23,6 +23,60 @@ namespace Delegates
 		}
 	}
 
+	void SearchMatcher::SetPattern(const QString & pattern)
+	{
+		m_pattern = pattern;
+		m_needle = pattern.toCaseFolded();
+
+		// Horspool: сдвиг для символа - расстояние от его последнего вхождения(кроме последнего символа) до конца образца.
+		// Символы с одинаковым младшим байтом делят ячейку - берется минимальный сдвиг, что корректно(сдвиг лишь меньше возможного)
+		const int len = m_needle.length();
+		m_skip.fill(len);
+		for (int i = 0; i < len - 1; ++i)
+			m_skip[m_needle[i].unicode() & 0xFF] = len - 1 - i;
+	}
+
+	int SearchMatcher::IndexIn(const QString & text, int from) const noexcept
+	{
+		const int len = m_needle.length();
+		const int textLen = text.length();
+		if (len == 0 or from < 0) return -1;
+
+		const QChar * needle = m_needle.constData();
+		const QChar * data = text.constData();
+		const int last = len - 1;
+
+		for (int pos = from; pos + len <= textLen;)
+		{
+			const QChar tail = data[pos + last].toCaseFolded();
+			if (tail == needle[last])
+			{
+				int i = last - 1;
+				while (i >= 0 and data[pos + i].toCaseFolded() == needle[i]) --i;
+				if (i < 0) return pos;
+			}
+
+			pos += m_skip[tail.unicode() & 0xFF];
+		}
+
+		return -1;
+	}
+
+	void FormatSearchText(const QString & text, const SearchMatcher & matcher, const QTextCharFormat & format, QVector<QTextLayout::FormatRange> & formats)
+	{
+		if (matcher.IsEmpty()) return;
+
+		const int length = matcher.Length();
+		for (int index = matcher.IndexIn(text); index >= 0; index = matcher.IndexIn(text, index + length))
+		{
+			QTextLayout::FormatRange fmt;
+			fmt.start = index;
+			fmt.length = length;
+			fmt.format = format; // QTextCharFormat implicitly shared, копирование дешевое
+			formats.push_back(std::move(fmt));
+		}
+	}
+
 	auto FormatSearchText(const QString & text, const QString & filterWord, const QTextCharFormat & format)
 		-> QVector<QTextLayout::FormatRange>
 	{
@@ -84,41 +138,34 @@ namespace Delegates
 			auto line = textLayout.lineAt(elideIdx);
 			drawRect.adjust(0, drawRect.height() - line.height(), 0, 0);
 
-			int elidePoint = line.textStart();
-			QString elidedText = text.mid(elidePoint);
-			auto fontMetrics = painter->fontMetrics();   // painter is already prepared
-			elidedText = ElideText(fontMetrics, elidedText, opt.textElideMode, drawRect.width());
-
-			auto elidedFormats = ElideFormats(selectionFormats, elidePoint);
-			ColorifyElidePoint(elidedText, elidedFormats);
-
-			QTextLayout elideLayout(elidedText, opt.font, painter->device());
-			elideLayout.setTextOption(textOption);
-			elideLayout.setFormats(selectionFormats);
-			elideLayout.setCacheEnabled(true);
-
-			DoLayout(elideLayout, drawRect);
-			// обманываем, нам нужно что бы он нарисовал одну единственную линию
-			DrawLayout(painter, drawRect.topLeft(), elideLayout, 1);
+			// усекаем по уже размеченной линии, без повторной разметки,
+			// многоточие раскрашивается, если скрытый текст содержит совпадения
+			DrawElidedLine(painter, drawRect, textLayout, elideIdx, opt.textElideMode, selectionFormats);
 		}
 	}
 
 	void SearchDelegate::FormatText(const QString & text, QVector<QTextLayout::FormatRange> & formats) const
 	{
-		FormatSearchText(text, m_searchText, m_format, formats);
+		FormatSearchText(text, m_matcher, m_format, formats);
 	}
 
 	void SearchDelegate::DrawText(QPainter * painter, QStyleOptionViewItem & opt) const
 	{
-		QVector<QTextLayout::FormatRange> formats;
-		FormatText(opt.text, formats);
+		// resize(0) сохраняет выделенную память, буфер переиспользуется от ячейки к ячейке
+		m_formats.resize(0);
+		FormatText(opt.text, m_formats);
 
-		auto rect = TextSubrect(opt);
-		RemoveTextMargin(opt, rect);
+		const auto & metrics = Metrics(opt);
+		auto rect = TextSubrect(metrics, opt);
+		RemoveTextMargin(metrics, rect);
 
 		PreparePainter(painter, opt);
 		DrawEditingFrame(painter, rect, opt);
-		DrawSearchFormatedText(painter, opt.text, rect, opt, formats);
+		// нет совпадений - пробуем быстрый путь через QStaticText
+		if (m_formats.isEmpty() and DrawPlainText(painter, opt.text, rect, opt, m_textCache))
+			return;
+
+		DrawSearchFormatedText(painter, opt.text, rect, opt, m_formats);
 	}
 }}
 
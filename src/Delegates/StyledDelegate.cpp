@@ -2,6 +2,7 @@
 #include <QtTools/Delegates/StyledParts.hpp>
 #include <QtTools/Delegates/DrawFormattedText.hpp>
 #include <QtGui/QPainter>
+#include <QtWidgets/QApplication>
 
 namespace QtTools {
 namespace Delegates
@@ -11,43 +12,56 @@ namespace Delegates
 		initStyleOption(&option, index);
 	}
 
+	const StyleMetrics & StyledDelegate::Metrics(const QStyleOptionViewItem & option) const
+	{
+		// delegate обычно рисует в одном view - ищем метрики среди детей виджета только при его смене
+		if (not m_metrics or m_metrics->GetWidget() != option.widget)
+			m_metrics = &AccquireStyleMetrics(option);
+
+		return *m_metrics;
+	}
+
 	void StyledDelegate::DrawBackground(QPainter * painter, QStyleOptionViewItem & option) const
 	{
-		Delegates::DrawBackground(painter, option);
+		Delegates::DrawBackground(painter, Metrics(option), option);
 	}
 
 	void StyledDelegate::DrawCheckmark(QPainter * painter, QStyleOptionViewItem & option) const
 	{
-		Delegates::DrawCheckmark(painter, Delegates::CheckmarkSubrect(option), option);
+		const auto & metrics = Metrics(option);
+		Delegates::DrawCheckmark(painter, metrics, Delegates::CheckmarkSubrect(metrics, option), option);
 	}
 
 	void StyledDelegate::DrawDecoration(QPainter * painter, QStyleOptionViewItem & option) const
 	{
-		Delegates::DrawDecoration(painter, Delegates::DecorationSubrect(option), option);
+		Delegates::DrawDecoration(painter, Delegates::DecorationSubrect(Metrics(option), option), option);
 	}
 
 	void StyledDelegate::DrawText(QPainter * painter, QStyleOptionViewItem & option) const
 	{
 		using namespace Delegates;
 		
-		auto rect = TextSubrect(option);
-		RemoveTextMargin(option, rect);
+		const auto & metrics = Metrics(option);
+		auto rect = TextSubrect(metrics, option);
+		RemoveTextMargin(metrics, rect);
 
 		PreparePainter(painter, option);
 		DrawEditingFrame(painter, rect, option);
-		DrawFormattedText(painter, option.text, rect, option);
+		if (not DrawPlainText(painter, option.text, rect, option, m_textCache))
+			DrawFormattedText(painter, option.text, rect, option);
 	}
 
 	void StyledDelegate::DrawFocusFrame(QPainter * painter, QStyleOptionViewItem & option) const
 	{
-		Delegates::DrawFocusFrame(painter, Delegates::FocusFrameSubrect(option), option);
+		const auto & metrics = Metrics(option);
+		Delegates::DrawFocusFrame(painter, metrics, Delegates::FocusFrameSubrect(metrics, option), option);
 	}
 
 	void StyledDelegate::paint(QPainter * painter, const QStyleOptionViewItem & option, const QModelIndex & index) const
 	{
 		auto opt = option;
 		InitStyle(opt, index);
-		FixStyleOptionViewItem(opt);
+		FixStyleOptionViewItem(opt, Metrics(opt));
 
 		painter->save();
 		// painter->setClipRect(opt.rect);
@@ -63,10 +77,77 @@ namespace Delegates
 		painter->restore();
 	}
 
+	bool StyledDelegate::SizeHintKey::operator ==(const SizeHintKey & other) const noexcept
+	{
+		return features == other.features
+		   and decorationPosition == other.decorationPosition
+		   and width == other.width
+		   and decorationSize == other.decorationSize
+		   and text == other.text
+		   and font == other.font;
+	}
+
+	uint qHash(const StyledDelegate::SizeHintKey & key, uint seed) noexcept
+	{
+		// qHash для QString/QFont/int находятся в глобальном пространстве имен и скрыты данной функцией
+		seed = ::qHash(key.text, seed);
+		seed = ::qHash(key.font, seed);
+		seed ^= ::qHash(key.features) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		seed ^= ::qHash(key.width) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		seed ^= ::qHash(key.decorationSize.width()) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		seed ^= ::qHash(key.decorationSize.height()) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		seed ^= ::qHash(key.decorationPosition) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		return seed;
+	}
+
+	void StyledDelegate::SetSizeHintCacheLimit(int limit)
+	{
+		m_sizeHintCacheLimit = limit;
+		if (m_sizeHintCache.size() > limit)
+			m_sizeHintCache.clear();
+	}
+
 	QSize StyledDelegate::sizeHint(const QStyleOptionViewItem & option, const QModelIndex & index) const
 	{
+		// явный размер от модели - как и в QStyledItemDelegate, не кешируем
+		auto value = index.data(Qt::SizeHintRole);
+		if (value.isValid())
+			return qvariant_cast<QSize>(value);
+
 		auto opt = option;
 		InitStyle(opt, index);
-		return QStyledItemDelegate::sizeHint(opt, index);
+
+		if (m_sizeHintCacheLimit <= 0)
+			return QStyledItemDelegate::sizeHint(opt, index);
+
+		// смена стиля(в том числе style sheet) меняет отступы и размеры - кеш более не актуален
+		const QStyle * style = opt.widget ? opt.widget->style() : QApplication::style();
+		if (style != m_sizeHintStyle)
+		{
+			m_sizeHintCache.clear();
+			m_sizeHintStyle = style;
+		}
+
+		const auto featuresMask = QStyleOptionViewItem::WrapText | QStyleOptionViewItem::HasDisplay
+		                            | QStyleOptionViewItem::HasDecoration | QStyleOptionViewItem::HasCheckIndicator;
+
+		SizeHintKey key;
+		key.text = opt.text;
+		key.font = opt.font;
+		key.decorationSize = opt.decorationSize;
+		key.features = static_cast<int>(opt.features & featuresMask);
+		key.decorationPosition = opt.decorationPosition;
+		key.width = opt.features & QStyleOptionViewItem::WrapText ? opt.rect.width() : -1;
+
+		auto it = m_sizeHintCache.find(key);
+		if (it != m_sizeHintCache.end())
+			return *it;
+
+		if (m_sizeHintCache.size() >= m_sizeHintCacheLimit)
+			m_sizeHintCache.clear();
+
+		auto size = QStyledItemDelegate::sizeHint(opt, index);
+		m_sizeHintCache.insert(std::move(key), size);
+		return size;
 	}
 }}
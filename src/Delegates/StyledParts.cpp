@@ -1,5 +1,6 @@
 #include <QtTools/Delegates/StyledParts.hpp>
 #include <QtCore/QString>
+#include <QtCore/QEvent>
 #include <QtGui/QPainter>
 #include <QtWidgets/QStyleFactory>
 #include <QtWidgets/QTableView>
@@ -15,14 +16,11 @@ namespace Delegates
 	}
 #endif
 
-	void FixStyleOptionViewItem(QStyleOptionViewItem & opt)
+	static void FixVistaStyleOptionViewItem(QStyleOptionViewItem & opt)
 	{
 #ifdef Q_OS_WIN
 
 		// taken from qwindowsvistastyle.cpp: 1443 qt 5.3
-		if (!IsWindowsVistaStyle(AccquireStyle(opt)))
-			return;
-
 		const QAbstractItemView *view = qobject_cast<const QAbstractItemView *>(opt.widget);
 		bool newStyle = true;
 
@@ -52,14 +50,143 @@ namespace Delegates
 #endif // Q_OS_WIN
 	}
 
-	void DrawBackground(QPainter * painter, const QStyleOptionViewItem & opt)
+	void FixStyleOptionViewItem(QStyleOptionViewItem & opt)
+	{
+#ifdef Q_OS_WIN
+		if (IsWindowsVistaStyle(AccquireStyle(opt)))
+			FixVistaStyleOptionViewItem(opt);
+#endif // Q_OS_WIN
+	}
+
+	void FixStyleOptionViewItem(QStyleOptionViewItem & opt, const StyleMetrics & metrics)
+	{
+		if (metrics.IsWindowsVistaStyle())
+			FixVistaStyleOptionViewItem(opt);
+	}
+
+	/************************************************************************/
+	/*            StyleMetrics                                              */
+	/************************************************************************/
+	bool StyleMetrics::SubrectsKey::operator ==(const SubrectsKey & other) const noexcept
+	{
+		return rect == other.rect
+		   and features == other.features
+		   and state == other.state
+		   and checkState == other.checkState
+		   and viewItemPosition == other.viewItemPosition
+		   and decorationPosition == other.decorationPosition
+		   and decorationAlignment == other.decorationAlignment
+		   and displayAlignment == other.displayAlignment
+		   and direction == other.direction
+		   and decorationSize == other.decorationSize;
+	}
+
+	uint qHash(const StyleMetrics::SubrectsKey & key, uint seed) noexcept
+	{
+		// qHash для int находится в глобальном пространстве имен и скрыт данной функцией
+		const int values[] = {
+			key.rect.x(), key.rect.y(), key.rect.width(), key.rect.height(),
+			key.decorationSize.width(), key.decorationSize.height(),
+			key.features, key.state, key.checkState, key.viewItemPosition, key.decorationPosition,
+			key.decorationAlignment, key.displayAlignment, key.direction,
+		};
+
+		for (int val : values)
+			seed ^= ::qHash(val) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+
+		return seed;
+	}
+
+	StyleMetrics::StyleMetrics(QWidget * widget)
+		: QObject(widget), m_widget(widget)
+	{
+		Refresh();
+		widget->installEventFilter(this);
+	}
+
+	void StyleMetrics::Refresh()
+	{
+		m_subrects.clear();
+		m_style = m_widget->style();
+		m_textMargin = TextMargin(m_style);
+#ifdef Q_OS_WIN
+		m_windowsVistaStyle = Delegates::IsWindowsVistaStyle(m_style);
+#endif
+	}
+
+	bool StyleMetrics::eventFilter(QObject * watched, QEvent * event)
+	{
+		if (watched == m_widget)
+		{
+			switch (event->type())
+			{
+				case QEvent::StyleChange:
+				case QEvent::FontChange:
+				case QEvent::PaletteChange:
+					Refresh();
+					break;
+
+				default: break;
+			}
+		}
+
+		return QObject::eventFilter(watched, event);
+	}
+
+	auto StyleMetrics::GetSubrects(const QStyleOptionViewItem & opt) const -> const Subrects &
+	{
+		SubrectsKey key;
+		key.rect = opt.rect;
+		key.decorationSize = opt.decorationSize;
+		key.features = static_cast<int>(opt.features);
+		key.state = static_cast<int>(opt.state);
+		key.checkState = opt.checkState;
+		key.viewItemPosition = opt.viewItemPosition;
+		key.decorationPosition = opt.decorationPosition;
+		key.decorationAlignment = static_cast<int>(opt.decorationAlignment);
+		key.displayAlignment = static_cast<int>(opt.displayAlignment);
+		key.direction = opt.direction;
+
+		auto it = m_subrects.find(key);
+		if (it != m_subrects.end())
+			return *it;
+
+		if (m_subrects.size() >= SubrectsCacheLimit)
+			m_subrects.clear();
+
+		Subrects subrects;
+		subrects.check = m_style->subElementRect(QStyle::SE_ItemViewItemCheckIndicator, &opt, opt.widget);
+		subrects.decoration = m_style->subElementRect(QStyle::SE_ItemViewItemDecoration, &opt, opt.widget);
+		subrects.text = m_style->subElementRect(QStyle::SE_ItemViewItemText, &opt, opt.widget);
+		subrects.focus = m_style->subElementRect(QStyle::SE_ItemViewItemFocusRect, &opt, opt.widget);
+
+		return *m_subrects.insert(key, subrects);
+	}
+
+	StyleMetrics & AccquireStyleMetrics(const QStyleOptionViewItem & opt)
+	{
+		auto * widget = const_cast<QWidget *>(opt.widget);
+		for (auto * child : widget->children())
+		{
+			auto * metrics = dynamic_cast<StyleMetrics *>(child);
+			if (not metrics) continue;
+
+			if (metrics->GetStyle() != widget->style())
+				metrics->Refresh();
+
+			return *metrics;
+		}
+
+		return *new StyleMetrics(widget);
+	}
+
+	static void DrawBackground(QPainter * painter, const QStyle * style, const QStyleOptionViewItem & opt)
 	{
 		// code taken from: qcommonstyle.cpp:2156 qt 5.3
-		auto * style = AccquireStyle(opt);
 		style->drawPrimitive(QStyle::PE_PanelItemViewItem, &opt, painter, opt.widget);
 	}
 
-	void DrawCheckmark(QPainter * painter, const QRect & checkRect, const QStyleOptionViewItem & opt)
+	static void DrawCheckmark(QPainter * painter, const QStyle * style, const QRect & checkRect, const QStyleOptionViewItem & opt)
 	{
 		// code taken from: qcommonstyle.cpp:2159 qt 5.3
 		QStyleOptionViewItem option = opt;
@@ -78,7 +205,6 @@ namespace Delegates
 			break;
 		}
 
-		auto * style = AccquireStyle(opt);
 		style->drawPrimitive(QStyle::PE_IndicatorViewItemCheck, &option, painter, opt.widget);
 	}
 
@@ -95,11 +221,9 @@ namespace Delegates
 		opt.icon.paint(painter, decorationRect, opt.decorationAlignment, mode, state);
 	}
 
-	void DrawFocusFrame(QPainter * painter, const QRect & focusRect, const QStyleOptionViewItem & opt)
+	static void DrawFocusFrame(QPainter * painter, const QStyle * style, const QRect & focusRect, const QStyleOptionViewItem & opt)
 	{
 		// code taken from: qcommonstyle.cpp:2209 qt 5.3
-		auto * style = AccquireStyle(opt);
-
 		QStyleOptionFocusRect focusOpt;
 		focusOpt.QStyleOption::operator =(opt);
 		focusOpt.rect = focusRect;
@@ -113,4 +237,34 @@ namespace Delegates
 
 		style->drawPrimitive(QStyle::PE_FrameFocusRect, &focusOpt, painter, opt.widget);
 	}
+
+	void DrawBackground(QPainter * painter, const QStyleOptionViewItem & opt)
+	{
+		DrawBackground(painter, AccquireStyle(opt), opt);
+	}
+
+	void DrawCheckmark(QPainter * painter, const QRect & checkRect, const QStyleOptionViewItem & opt)
+	{
+		DrawCheckmark(painter, AccquireStyle(opt), checkRect, opt);
+	}
+
+	void DrawFocusFrame(QPainter * painter, const QRect & focusRect, const QStyleOptionViewItem & opt)
+	{
+		DrawFocusFrame(painter, AccquireStyle(opt), focusRect, opt);
+	}
+
+	void DrawBackground(QPainter * painter, const StyleMetrics & metrics, const QStyleOptionViewItem & opt)
+	{
+		DrawBackground(painter, metrics.GetStyle(), opt);
+	}
+
+	void DrawCheckmark(QPainter * painter, const StyleMetrics & metrics, const QRect & checkRect, const QStyleOptionViewItem & opt)
+	{
+		DrawCheckmark(painter, metrics.GetStyle(), checkRect, opt);
+	}
+
+	void DrawFocusFrame(QPainter * painter, const StyleMetrics & metrics, const QRect & focusRect, const QStyleOptionViewItem & opt)
+	{
+		DrawFocusFrame(painter, metrics.GetStyle(), focusRect, opt);
+	}
 }}
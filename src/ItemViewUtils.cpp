@@ -1,3 +1,8 @@
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+#include <QtCore/QTimer>
 #include <QtWidgets/QHeaderView>
 #include <QtWidgets/QListView>
 #include <QtWidgets/QTableView>
@@ -21,6 +26,326 @@ namespace QtTools
 		using QTreeView::rowHeight;
 	};
 
+	/// calls func for a stratified sample of rows: rows are split into sampleSize equal strata,
+	/// and middle row of each stratum is taken. Small models are enumerated entirely
+	template <class Functor>
+	static void ForEachSampledRow(int rowCount, int sampleSize, Functor && func)
+	{
+		if (rowCount <= sampleSize)
+		{
+			for (int row = 0; row < rowCount; ++row)
+				func(row);
+
+			return;
+		}
+
+		const double stride = static_cast<double>(rowCount) / sampleSize;
+		for (int i = 0; i < sampleSize; ++i)
+			func(static_cast<int>(stride * i + stride / 2));
+	}
+
+	/// rows [first, last) currently shown in table view viewport, empty if view is not laid out yet
+	static std::pair<int, int> VisibleRows(const QTableView * view, int rowCount)
+	{
+		int first = view->rowAt(0);
+		if (first < 0) return {0, 0};
+
+		int last = view->rowAt(view->viewport()->height() - 1);
+		if (last < 0) last = rowCount - 1;
+
+		return {first, last + 1};
+	}
+
+	/// measures list view rows area. Large models(see ItemViewSampling) are measured by
+	/// visible rows and a sample, height is extrapolated by average row height
+	static QRect ListViewArea(const QListView * view, const ItemViewSampling & sampling)
+	{
+		const auto * model = view->model();
+		constexpr QModelIndex parent;
+		const int rc = model->rowCount(parent);
+		const int mc = view->modelColumn();
+
+		QRect area;
+		if (rc <= sampling.exactLimit)
+		{
+			for (int i = 0; i < rc; ++i)
+				area |= view->visualRect(model->index(i, mc, parent));
+
+			return area;
+		}
+
+		int measured = 0, measuredHeight = 0;
+		auto measure = [&](int row)
+		{
+			auto rect = view->visualRect(model->index(row, mc, parent));
+			if (rect.isEmpty()) return; // hidden or not laid out yet
+
+			area |= rect;
+			measuredHeight += rect.height() + view->spacing();
+			++measured;
+		};
+
+		const int firstVisible = view->indexAt({0, 0}).row();
+		const int lastVisible = view->indexAt({0, view->viewport()->height() - 1}).row();
+		if (firstVisible >= 0)
+		{
+			for (int row = firstVisible; row <= (lastVisible >= 0 ? lastVisible : rc - 1); ++row)
+				measure(row);
+		}
+
+		ForEachSampledRow(rc, sampling.sampleSize, measure);
+		if (measured)
+			area.setHeight(static_cast<int>(static_cast<double>(measuredHeight) / measured * rc));
+
+		return area;
+	}
+
+	/// Measures all rows of a table view in event loop slices, see ItemViewSampling::progressive.
+	/// Lives as a child of the view and keeps per column maximums, which are kept up to date with row insertions and data changes
+	/// while measurement is running. When it's done - measurer deletes itself, unless ItemViewSampling::trackChanges was requested.
+	/// Model reset and column changes drop it.
+	class ProgressiveColumnsMeasurer : public QObject
+	{
+		QTableView * m_view;
+		QAbstractItemModel * m_model;
+		std::vector<int> m_maximums; // per logical column
+		int m_nextRow = 0;           // rows [0, m_nextRow) are measured
+		int m_sliceSize = 2000;
+		bool m_resizing = false;     // grow columns while measurement started by ResizeColumnsToContents is in progress
+		bool m_tracking = false;     // stay attached to the model after measurement is complete
+		bool m_scrambled = false;    // layout changed while measuring - unmeasured rows could have moved into [0, m_nextRow)
+		int m_rescans = 0;           // passes restarted because of m_scrambled since last Start
+		QTimer m_timer;
+
+		// live models can change layout continuously(sorting, filtering, erasing),
+		// pass is restarted for scrambled rows only this number of times, then measurement is considered complete
+		static constexpr int ms_maxRescans = 2;
+
+	private:
+		void MeasureRows(int first, int last);
+		void Slice();
+		void Invalidate();
+
+		void OnRowsInserted(const QModelIndex & parent, int first, int last);
+		void OnRowsRemoved(const QModelIndex & parent, int first, int last);
+		void OnDataChanged(const QModelIndex & topLeft, const QModelIndex & bottomRight);
+		void OnLayoutChanged();
+
+	public:
+		/// finds measurer of the view, if any
+		static ProgressiveColumnsMeasurer * Find(const QTableView * view);
+
+		bool IsComplete() const { return m_nextRow >= m_model->rowCount(m_view->rootIndex()); }
+		int  Maximum(int column) const { return column < static_cast<int>(m_maximums.size()) ? m_maximums[column] : 0; }
+		/// continues measurement of not yet measured rows, growing columns of the view.
+		/// If tracking is false - measurer is deleted when measurement is complete
+		void Start(int sliceSize, bool tracking);
+
+	public:
+		ProgressiveColumnsMeasurer(QTableView * view);
+	};
+
+	ProgressiveColumnsMeasurer::ProgressiveColumnsMeasurer(QTableView * view)
+		: QObject(view), m_view(view), m_model(view->model())
+	{
+		m_maximums.assign(m_model->columnCount(m_view->rootIndex()), 0);
+		m_timer.setInterval(0);
+
+		connect(&m_timer, &QTimer::timeout, this, &ProgressiveColumnsMeasurer::Slice);
+		connect(m_model, &QObject::destroyed, this, &ProgressiveColumnsMeasurer::Invalidate);
+		connect(m_model, &QAbstractItemModel::modelReset, this, &ProgressiveColumnsMeasurer::Invalidate);
+		connect(m_model, &QAbstractItemModel::columnsInserted, this, &ProgressiveColumnsMeasurer::Invalidate);
+		connect(m_model, &QAbstractItemModel::columnsRemoved, this, &ProgressiveColumnsMeasurer::Invalidate);
+		connect(m_model, &QAbstractItemModel::columnsMoved, this, &ProgressiveColumnsMeasurer::Invalidate);
+		connect(m_model, &QAbstractItemModel::rowsInserted, this, &ProgressiveColumnsMeasurer::OnRowsInserted);
+		connect(m_model, &QAbstractItemModel::rowsRemoved, this, &ProgressiveColumnsMeasurer::OnRowsRemoved);
+		connect(m_model, &QAbstractItemModel::dataChanged, this, &ProgressiveColumnsMeasurer::OnDataChanged);
+		connect(m_model, &QAbstractItemModel::layoutChanged, this, &ProgressiveColumnsMeasurer::OnLayoutChanged);
+		connect(m_model, &QAbstractItemModel::rowsMoved, this, &ProgressiveColumnsMeasurer::OnLayoutChanged);
+	}
+
+	ProgressiveColumnsMeasurer * ProgressiveColumnsMeasurer::Find(const QTableView * view)
+	{
+		for (auto * child : view->children())
+		{
+			auto * measurer = dynamic_cast<ProgressiveColumnsMeasurer *>(child);
+			if (not measurer) continue;
+
+			// view was switched to another model
+			if (measurer->m_model != view->model())
+			{
+				measurer->Invalidate();
+				return nullptr;
+			}
+
+			return measurer;
+		}
+
+		return nullptr;
+	}
+
+	void ProgressiveColumnsMeasurer::Invalidate()
+	{
+		m_timer.stop();
+		// no more model notifications, and detach from the view, so Find would not see us anymore
+		m_model->disconnect(this);
+		setParent(nullptr);
+		deleteLater();
+	}
+
+	void ProgressiveColumnsMeasurer::Start(int sliceSize, bool tracking)
+	{
+		m_sliceSize = std::max(1, sliceSize);
+		m_tracking = tracking;
+		m_rescans = 0;
+		if (IsComplete())
+		{
+			if (not m_tracking) Invalidate();
+			return;
+		}
+
+		m_resizing = true;
+		m_timer.start();
+	}
+
+	void ProgressiveColumnsMeasurer::MeasureRows(int first, int last)
+	{
+		const auto root = m_view->rootIndex();
+		const int grid = m_view->showGrid() ? 1 : 0;
+		const int columns = static_cast<int>(m_maximums.size());
+		auto * header = m_view->horizontalHeader();
+
+		for (int column = 0; column < columns; ++column)
+		{
+			int hint = 0;
+			for (int row = first; row < last; ++row)
+			{
+				if (m_view->isRowHidden(row)) continue;
+				auto width = m_view->sizeHintForIndex(m_model->index(row, column, root)).width() + grid;
+				hint = std::max(hint, width);
+			}
+
+			if (hint <= m_maximums[column]) continue;
+
+			m_maximums[column] = hint;
+			// only grow, never fight with user shrinking columns
+			if (m_resizing and not header->isSectionHidden(column) and hint > header->sectionSize(column))
+				header->resizeSection(column, hint);
+		}
+	}
+
+	void ProgressiveColumnsMeasurer::Slice()
+	{
+		const int rowCount = m_model->rowCount(m_view->rootIndex());
+		const int last = std::min(rowCount, m_nextRow + m_sliceSize);
+
+		MeasureRows(m_nextRow, last);
+		m_nextRow = last;
+
+		if (m_nextRow >= rowCount)
+		{
+			if (std::exchange(m_scrambled, false) and m_rescans < ms_maxRescans)
+			{
+				// rows could have moved into already measured range unmeasured - one more pass.
+				// Maximums are kept: they are still valid lower bounds
+				++m_rescans;
+				m_nextRow = 0;
+				return;
+			}
+
+			m_timer.stop();
+			m_resizing = false;
+			// one-off resize - do not burden further model updates
+			if (not m_tracking) Invalidate();
+		}
+	}
+
+	void ProgressiveColumnsMeasurer::OnRowsInserted(const QModelIndex & parent, int first, int last)
+	{
+		if (parent != m_view->rootIndex()) return;
+
+		// rows after m_nextRow will be measured by slices, if measurement is running.
+		// rows inserted into already measured range, or appended after measurement is complete(tracking),
+		// are measured right away, if there are not too many of them
+		const int count = last - first + 1;
+		if (first > m_nextRow or (first == m_nextRow and m_timer.isActive())) return;
+
+		if (count <= m_sliceSize)
+		{
+			m_nextRow += count;
+			MeasureRows(first, last + 1);
+		}
+		else
+		{
+			// tracking measurer keeps maximums complete, big insertions are measured in slices
+			m_nextRow = first;
+			if (m_resizing or m_tracking) m_timer.start();
+		}
+	}
+
+	void ProgressiveColumnsMeasurer::OnRowsRemoved(const QModelIndex & parent, int first, int last)
+	{
+		if (parent != m_view->rootIndex()) return;
+
+		// maximums are not shrunk: they can only overestimate, which is fine for column widths
+		const int count = last - first + 1;
+		if (first < m_nextRow)
+			m_nextRow -= std::min(count, m_nextRow - first);
+	}
+
+	void ProgressiveColumnsMeasurer::OnDataChanged(const QModelIndex & topLeft, const QModelIndex & bottomRight)
+	{
+		if (topLeft.parent() != m_view->rootIndex()) return;
+
+		const int first = topLeft.row();
+		const int last = std::min(bottomRight.row() + 1, m_nextRow);
+		if (first >= last) return;
+
+		if (last - first <= m_sliceSize)
+			MeasureRows(first, last);
+		else
+		{
+			m_nextRow = first;
+			if (m_resizing) m_timer.start();
+		}
+	}
+
+	void ProgressiveColumnsMeasurer::OnLayoutChanged()
+	{
+		// complete set of rows is just permuted - maximums are still exact.
+		// partially measured set is scrambled - maximums are still valid lower bounds, measurement continues from m_nextRow,
+		// rows which moved into already measured range are caught by a rescan at the end of the pass, see Slice
+		if (IsComplete()) return;
+
+		m_scrambled = true;
+	}
+
+	/// resizes visible sections of header to hint(logicalIndex), but no less than minimumSectionSize
+	template <class HintFunctor>
+	static void ResizeSections(QHeaderView * header, HintFunctor && hint)
+	{
+		auto minimum = header->minimumSectionSize();
+		int count = header->count();
+
+		for (int i = 0; i < count; ++i)
+		{
+			auto li = header->logicalIndex(i);
+			if (not header->isSectionHidden(li))
+				header->resizeSection(li, std::max(hint(li), minimum));
+		}
+	}
+
+	/// indentation of tree view item: depth relative to root index, plus root decoration
+	static int TreeIndentation(const QTreeView * view, QModelIndex index)
+	{
+		const auto root = view->rootIndex();
+		int depth = view->rootIsDecorated() ? 1 : 0;
+		for (index = index.parent(); index.isValid() and index != root; index = index.parent())
+			++depth;
+
+		return depth * view->indentation();
+	}
+
 	int CalculateDefaultRowHeight(const QTableView * view)
 	{
 		return 21;
@@ -36,25 +361,12 @@ namespace QtTools
 		return width;
 	}
 
-	int ItemViewWidthHint(const QListView * view, bool withScrollBar)
+	int ItemViewWidthHint(const QListView * view, bool withScrollBar, const ItemViewSampling & sampling)
 	{
 		const auto * model = view->model();
 		if (not model) return view->sizeHint().width();
 		
-		constexpr QModelIndex parent;
-		const int rc = model->rowCount(parent);
-		const int mc = view->modelColumn();
-		
-		int width = 0;
-		QRect area;
-		
-		for (int i = 0; i < rc; ++i)
-		{
-			auto rect = view->visualRect(model->index(i, mc, parent));
-			area |= rect;
-			width = area.width();
-		}
-
+		int width = ListViewArea(view, sampling).width();
 		width += view->frameWidth() * 2;
 		
 		if (withScrollBar)
@@ -66,25 +378,12 @@ namespace QtTools
 		return width;
 	}
 	
-	int ItemViewHeightHint(const QListView * view, bool withScrollBar)
+	int ItemViewHeightHint(const QListView * view, bool withScrollBar, const ItemViewSampling & sampling)
 	{
 		const auto * model = view->model();
 		if (not model) return view->sizeHint().width();
 		
-		constexpr QModelIndex parent;
-		const int rc = model->rowCount(parent);
-		const int mc = view->modelColumn();
-		
-		int height = 0;
-		QRect area;
-		
-		for (int i = 0; i < rc; ++i)
-		{
-			auto rect = view->visualRect(model->index(i, mc, parent));
-			area |= rect;
-			height = area.height();
-		}
-
+		int height = ListViewArea(view, sampling).height();
 		height += view->frameWidth() * 2;
 		
 		if (withScrollBar)
@@ -128,11 +427,8 @@ namespace QtTools
 		auto * model = view->model();
 		if (not model) return view->sizeHint().height();
 
-		int count = model->rowCount();
-		int height = 0;
-
-		for (int i = 0; i < count; ++i)
-			height += view->rowHeight(i);
+		// vertical header keeps total length of its sections(hidden rows are 0), no need to sum rowHeight for every row
+		int height = view->verticalHeader()->length();
 
 		height += view->frameWidth() * 2;
 		auto * hhdr = view->horizontalHeader();
@@ -171,18 +467,32 @@ namespace QtTools
 		return width;
 	}
 
-	int ItemViewHeightHint(const QTreeView * view, bool withScrollBar)
+	int ItemViewHeightHint(const QTreeView * view, bool withScrollBar, const ItemViewSampling & sampling)
 	{
 		// смотри также реализацию TableSizeHint, там есть важные пояснения
 		auto * model = view->model();
 		if (not model) return view->sizeHint().width();
 
 		QRect visualRect;
+		int count = 0;
+		auto index = view->indexAt({0, 0});
 
-		for (auto index = view->indexAt({0, 0}); index.isValid(); index = view->indexBelow(index))
+		for (; index.isValid() and count < sampling.exactLimit; index = view->indexBelow(index), ++count)
 			visualRect |= view->visualRect(index);
 
-		int height = visualRect.height() + view->frameWidth() * 2;
+		int height = visualRect.height();
+		// большое дерево: не обходим все раскрытые элементы, а экстраполируем.
+		// Общее количество(или высоту) раскрытых элементов дерево уже знает - это диапазон вертикального scrollbar'а
+		if (index.isValid() and count > 0)
+		{
+			auto * sb = view->verticalScrollBar();
+			if (view->verticalScrollMode() == QAbstractItemView::ScrollPerPixel)
+				height = sb->maximum() + view->viewport()->height();
+			else
+				height = static_cast<int>(static_cast<double>(height) / count * (sb->maximum() + sb->pageStep()));
+		}
+
+		height += view->frameWidth() * 2;
 		auto * vhdr = view->header();
 		if (not vhdr->isHidden())
 			height += vhdr->width();
@@ -444,51 +754,118 @@ namespace QtTools
 	}
 
 
-	void ResizeColumnsToContents(QTreeView * treeView)
+	void ResizeColumnsToContents(QTreeView * treeView, const ItemViewSampling & sampling)
 	{
+		auto * model = treeView->model();
+		if (not model) return;
+
 		QApplication::setOverrideCursor(Qt::WaitCursor);
 
 		// what we need is done by resizeColumnsToContents,
 		// but it's also takes into account headers, and i want without them - have to do by hand
 		auto * header = treeView->header();
-		auto minimum = header->minimumSectionSize();
-		int count = header->count();
+		const auto root = treeView->rootIndex();
+		const int rowCount = model->rowCount(root);
 
-		for (int i = 0; i < count; ++i)
+		if (rowCount <= sampling.exactLimit)
 		{
-			auto li = header->logicalIndex(i);
-			if (not header->isSectionHidden(li))
+			ResizeSections(header, [treeView](int li)
 			{
 				// for some unknown reason virtual method sizeHintForColumn is declared as protected in QTableView,
 				// through it's public QAbstractItemView. call through base class
-				auto hint = static_cast<QAbstractItemView *>(treeView)->sizeHintForColumn(li);
-				//auto headerHint = header->sectionSizeHint(li);
-				header->resizeSection(i, std::max(hint, minimum));
+				return static_cast<QAbstractItemView *>(treeView)->sizeHintForColumn(li);
+			});
+		}
+		else
+		{
+			// large tree: measure expanded items shown in the viewport plus a stratified sample of top level rows
+			std::vector<QModelIndex> rows;
+			const int viewportHeight = treeView->viewport()->height();
+			for (auto index = treeView->indexAt({0, 0}); index.isValid(); index = treeView->indexBelow(index))
+			{
+				if (treeView->visualRect(index).top() >= viewportHeight) break;
+				rows.push_back(index);
 			}
+
+			ForEachSampledRow(rowCount, sampling.sampleSize, [&](int row)
+			{
+				if (not treeView->isRowHidden(row, root))
+					rows.push_back(model->index(row, 0, root));
+			});
+
+			const int treeColumn = header->logicalIndex(0);
+			ResizeSections(header, [&](int li)
+			{
+				int hint = 0;
+				for (const auto & row : rows)
+				{
+					auto index = row.sibling(row.row(), li);
+					int width = treeView->sizeHintForIndex(index).width();
+					if (li == treeColumn) width += TreeIndentation(treeView, index);
+					hint = std::max(hint, width);
+				}
+
+				return hint;
+			});
 		}
 
 		QApplication::restoreOverrideCursor();
 	}
 
-	void ResizeColumnsToContents(QTableView * tableView)
+	void ResizeColumnsToContents(QTableView * tableView, const ItemViewSampling & sampling)
 	{
+		auto * model = tableView->model();
+		if (not model) return;
+
 		QApplication::setOverrideCursor(Qt::WaitCursor);
 
 		// what we need is done by resizeColumnsToContents,
 		// but it's also takes into account headers, and i want without them - have to do by hand
 		auto * header = tableView->horizontalHeader();
-		auto minimum = header->minimumSectionSize();
-		int count = header->count();
+		const auto root = tableView->rootIndex();
+		const int rowCount = model->rowCount(root);
 
-		for (int i = 0; i < count; ++i)
+		if (rowCount <= sampling.exactLimit)
 		{
-			auto li = header->logicalIndex(i);
-			if (not header->isSectionHidden(i))
+			ResizeSections(header, [tableView](int li)
 			{
 				// for some unknown reason virtual method sizeHintForColumn is declared as protected in QTableView,
 				// through it's public QAbstractItemView. call through base class
-				auto hint = static_cast<QAbstractItemView *>(tableView)->sizeHintForColumn(li);
-				header->resizeSection(li, std::max(hint, minimum));
+				return static_cast<QAbstractItemView *>(tableView)->sizeHintForColumn(li);
+			});
+		}
+		else
+		{
+			// large table: measure rows shown in the viewport plus a stratified sample,
+			// if there are cached maximums from previous full progressive measurement - use them instead of the sample
+			auto * measurer = ProgressiveColumnsMeasurer::Find(tableView);
+
+			std::vector<int> rows;
+			auto visible = VisibleRows(tableView, rowCount);
+			for (int row = visible.first; row < visible.second; ++row)
+				rows.push_back(row);
+
+			if (not measurer or not measurer->IsComplete())
+				ForEachSampledRow(rowCount, sampling.sampleSize, [&rows](int row) { rows.push_back(row); });
+
+			const int grid = tableView->showGrid() ? 1 : 0;
+			ResizeSections(header, [&](int li)
+			{
+				int hint = measurer ? measurer->Maximum(li) : 0;
+				for (int row : rows)
+				{
+					if (tableView->isRowHidden(row)) continue;
+					auto width = tableView->sizeHintForIndex(model->index(row, li, root)).width() + grid;
+					hint = std::max(hint, width);
+				}
+
+				return hint;
+			});
+
+			if (sampling.progressive)
+			{
+				if (not measurer) measurer = new ProgressiveColumnsMeasurer(tableView);
+				measurer->Start(sampling.sliceSize, sampling.trackChanges);
 			}
 		}
 
@@ -46,7 +46,13 @@ namespace QtTools
 
 	QMimeData * ListModelBase::mimeData(const QModelIndexList & indexes) const
 	{
-		return new ListModel_MimeData(indexes);
+		std::vector<int> rows(indexes.size());
+		std::transform(indexes.begin(), indexes.end(), rows.begin(), std::mem_fn(&QModelIndex::row));
+		std::sort(rows.begin(), rows.end());
+		rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+		auto * model = const_cast<ListModelBase *>(this);
+		return new ListModel_MimeData(model, std::move(rows));
 	}
 
 	bool ListModelBase::canDropMimeData(const QMimeData * data, Qt::DropAction action,
@@ -62,16 +68,16 @@ namespace QtTools
 		auto * mdata = qobject_cast<const ListModel_MimeData *>(data);
 		if (!mdata) return false;
 
-		const QModelIndexList & elements = mdata->elements;
-		if (elements.empty()) return true;
+		// модель-источник уже уничтожена
+		auto * model = mdata->model.data();
+		if (!model) return false;
 
-		auto * model = const_cast<QAbstractItemModel *>(elements[0].model());
+		const auto & rows = mdata->rows;
+		if (rows.empty()) return true;
 
-		std::vector<int> indexes(elements.size());
-		auto first = indexes.data();
-		auto last  = first + indexes.size();
-		std::transform(elements.begin(), elements.end(), first, std::mem_fn(&QModelIndex::row));
-		std::sort(first, last);
+		// строки уже отсортированы и уникальны, см. mimeData
+		auto first = rows.data();
+		auto last  = first + rows.size();
 
 
 		// в нашем случае parent всегда invalid, поскольку мы не TreeModel
@@ -109,9 +115,16 @@ namespace QtTools
 					DndCopyBefore(*model, first, last, row);
 
 			case Qt::MoveAction:
-				return onto ?
+			{
+				bool moved = onto ?
 					DndMoveOnto(*model, first, last, row) :
 					DndMoveBefore(*model, first, last, row);
+
+				// перемещение внутри этой же модели уже выполнено целиком, см. ListModel::DndMoveWithin.
+				// drop не принимаем: иначе QAbstractItemView::startDrag получит MoveAction
+				// и удалит выделенные строки(clearOrRemove), которые теперь указывают на перемещенные элементы
+				return moved and model != this;
+			}
 		}
 	}
 }
@@ -1,8 +1,11 @@
 #include <tuple>
+#include <algorithm>
 #include <ext/config.hpp>
 #include <ext/utility.hpp>
 
 #include <QtCore/QEvent>
+#include <QtCore/QLocale>
+#include <QtCore/QDateTime>
 #include <QtCore/QTimer>
 #include <QtCore/QMetaObject>
 #include <QtCore/QMetaMethod>
@@ -13,6 +16,7 @@
 #include <QtWidgets/QDesktopWidget>
 
 #include <QtTools/NotificationSystem/NotificationSystem.hqt>
+#include <QtTools/NotificationSystem/NotificationSystemExt.hqt>
 #include <QtTools/NotificationSystem/NotificationPopupLayout.hqt>
 #include <QtTools/NotificationSystem/NotificationPopupLayoutExt.hqt>
 
@@ -67,6 +71,9 @@ namespace QtTools::NotificationSystem
 		: QObject(parent)
 	{
 		InitColors();
+
+		m_expirationTimer.setSingleShot(true);
+		connect(&m_expirationTimer, &QTimer::timeout, this, &NotificationPopupLayout::ProcessExpirations);
 	}
 
 	NotificationPopupLayout::NotificationPopupLayout(NotificationCenter & center, QObject * parent /* = nullptr */)
@@ -119,6 +126,10 @@ namespace QtTools::NotificationSystem
 
 	void NotificationPopupLayout::AddNotification(QPointer<const Notification> notification)
 	{
+		if (not notification) return;
+		if (ShouldFold(*notification))
+			return FoldNotification(*notification);
+
 		Item item;
 		item.notification = std::move(notification);
 
@@ -126,6 +137,79 @@ namespace QtTools::NotificationSystem
 		ScheduleUpdate();
 	}
 
+	bool NotificationPopupLayout::ShouldFold(const Notification & notification)
+	{
+		// folding is opt in, see SetPopupsRate
+		if (m_popupsRate == 0)
+			return false;
+
+		// there are already enough notifications waiting for a popup
+		auto first = m_items.begin();
+		auto last = m_items.end();
+		auto waiting = std::count_if(first, last, [](auto & item) { return not item.popup and not item.summary; });
+		if (static_cast<unsigned>(waiting) >= m_widgetsLimit)
+			return true;
+
+		auto now = std::chrono::steady_clock::now();
+		if (now - m_budgetStart >= std::chrono::seconds(1))
+		{
+			m_budgetStart = now;
+			m_budgetCount = 0;
+		}
+
+		return m_budgetCount++ >= m_popupsRate;
+	}
+
+	void NotificationPopupLayout::FoldNotification(const Notification & notification)
+	{
+		auto first = m_items.begin();
+		auto last = m_items.end();
+		// summary that is already moving out can't be reused - new one is started
+		auto it = std::find_if(first, last, [](auto & item) { return item.summary and not item.closing; });
+
+		if (it != last)
+		{
+			++m_foldedCount;
+			// summary takes most severe level of folded notifications
+			if (notification.Level() < m_summaryNotification->Level())
+			{
+				m_summaryNotification->Level(notification.Level());
+				m_summaryNotification->Priority(notification.Priority());
+			}
+
+			return UpdateSummary(*it);
+		}
+
+		// no summary item - start new summary
+		auto summary = std::make_unique<SimpleNotification>();
+		summary->Level(notification.Level());
+		summary->Priority(notification.Priority());
+		m_summaryNotification = std::move(summary);
+		m_foldedCount = 1;
+
+		Item item;
+		item.summary = true;
+		item.notification = m_summaryNotification.get();
+		UpdateSummary(item);
+
+		m_items.push_back(std::move(item));
+		ScheduleUpdate();
+	}
+
+	void NotificationPopupLayout::UpdateSummary(Item & item)
+	{
+		auto & summary = *m_summaryNotification;
+		summary.Title(tr("%n more notification(s)", nullptr, m_foldedCount));
+		summary.Timestamp(QDateTime::currentDateTime());
+
+		auto * popup = qobject_cast<NotificationPopupWidget *>(item.popup.data());
+		if (not popup) return;
+
+		popup->m_title->setText(summary.Title());
+		popup->m_timestamp->setText(popup->locale().toString(summary.Timestamp(), QLocale::ShortFormat));
+		CustomizePopup(summary, popup);
+	}
+
 	void NotificationPopupLayout::AddPopup(AbstractNotificationPopupWidget * popup)
 	{
 		Item item;
@@ -303,20 +387,59 @@ namespace QtTools::NotificationSystem
 		}
 
 		if (msecs != 0)
+			ext::unconst(this)->ScheduleExpiration(popup, std::chrono::milliseconds(msecs));
+	}
+
+	// m_expirations heap comparator: nearest deadline on top
+	constexpr auto ExpirationGreater = [](const auto & e1, const auto & e2) { return e1.first > e2.first; };
+
+	void NotificationPopupLayout::ScheduleExpiration(AbstractNotificationPopupWidget * popup, std::chrono::milliseconds timeout)
+	{
+		auto deadline = std::chrono::steady_clock::now() + timeout;
+		m_expirations.emplace_back(deadline, popup);
+		std::push_heap(m_expirations.begin(), m_expirations.end(), ExpirationGreater);
+
+		// only new nearest deadline needs timer rearming
+		if (m_expirations.front().second == popup)
+			RearmExpirationTimer();
+	}
+
+	void NotificationPopupLayout::RearmExpirationTimer()
+	{
+		if (m_expirations.empty())
+			return m_expirationTimer.stop();
+
+		using namespace std::chrono;
+		auto left = duration_cast<milliseconds>(m_expirations.front().first - steady_clock::now());
+		// round up, otherwise timer can fire slightly before deadline
+		m_expirationTimer.start(std::max<int>(0, left.count() + 1));
+	}
+
+	void NotificationPopupLayout::ProcessExpirations()
+	{
+		auto now = std::chrono::steady_clock::now();
+		bool expired = false;
+
+		while (not m_expirations.empty() and m_expirations.front().first <= now)
 		{
-			auto moveOut = [popup, that = ext::unconst(this)]() mutable
-			{
-				auto first = that->m_items.begin();
-				auto last = that->m_items.end();
-				auto it = std::find_if(first, last, [popup](auto & item) { return item.popup == popup; });
-				if (it == last) return;
-				
-				that->MoveOutPopup(*it);
-			};
+			std::pop_heap(m_expirations.begin(), m_expirations.end(), ExpirationGreater);
+			auto popup = std::move(m_expirations.back().second);
+			m_expirations.pop_back();
+
+			// popup can be already closed by user
+			if (not popup) continue;
 
-			QTimer::singleShot(msecs, popup, moveOut);
+			auto first = m_items.begin();
+			auto last = m_items.end();
+			auto it = std::find_if(first, last, [&popup](auto & item) { return item.popup == popup; });
+			if (it == last) continue;
+
+			MoveOutPopup(*it);
+			expired = true;
 		}
-			
+
+		if (expired) ScheduleUpdate();
+		RearmExpirationTimer();
 	}
 
 	auto NotificationPopupLayout::MakePopup(const Notification * notification) const 
@@ -382,6 +505,7 @@ namespace QtTools::NotificationSystem
 
 	void NotificationPopupLayout::MoveOutPopup(Item & item)
 	{
+		item.closing = true;
 		// already have moving out
 		if (item.moveOutAnimation) return;
 
@@ -637,6 +761,11 @@ namespace QtTools::NotificationSystem
 		m_widgetsLimit = limit;
 	}
 
+	void NotificationPopupLayout::SetPopupsRate(unsigned perSecond)
+	{
+		m_popupsRate = perSecond;
+	}
+
 	auto NotificationPopupLayout::GetColors() const -> std::tuple<QColor, QColor, QColor>
 	{
 		return std::make_tuple(m_errorColor, m_warnColor, m_infoColor);
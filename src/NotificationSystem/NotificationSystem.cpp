@@ -1,6 +1,9 @@
 #include <QtTools/NotificationSystem/NotificationSystem.hqt>
 #include <QtTools/NotificationSystem/NotificationSystemExt.hqt>
 
+#include <cstdlib> // for std::abs
+#include <algorithm>
+
 #include <QtCore/QStringBuilder>
 #include <QtCore/QThread>
 #include <QtGui/QTextDocument>
@@ -15,7 +18,7 @@ namespace QtTools::NotificationSystem
 	}
 
 	SimpleNotification::SimpleNotification(QString title, QString text, Qt::TextFormat textFmt,  QDateTime timestamp)
-	    : m_timestamp(std::move(timestamp)), m_title(std::move(title)), m_text(std::move(text)), m_textFmt(textFmt),
+	    : m_timestamp(std::move(timestamp)), m_timestampMSecs(m_timestamp.toMSecsSinceEpoch()), m_title(std::move(title)), m_text(std::move(text)), m_textFmt(textFmt),
 	      m_priority(Normal), m_level(Info), m_priority_inited(0), m_level_inited(0)
 	{
 
@@ -75,6 +78,31 @@ namespace QtTools::NotificationSystem
 		return std::exchange(m_fullTextFmt, std::move(fmt));
 	}
 
+	QDateTime SimpleNotification::Timestamp(QDateTime timestamp)
+	{
+		m_timestampMSecs = timestamp.toMSecsSinceEpoch();
+		return std::exchange(m_timestamp, std::move(timestamp));
+	}
+
+	bool SimpleNotification::AddOccurrence(QDateTime timestamp)
+	{
+		++m_occurrences;
+		if (timestamp > LastSeen())
+			m_lastSeen = std::move(timestamp);
+
+		return true;
+	}
+
+	void NotificationStore::NotifyUpdated(std::vector<const Notification *> updated)
+	{
+		// views expect updated range sorted by pointer value
+		std::sort(updated.begin(), updated.end());
+		updated.erase(std::unique(updated.begin(), updated.end()), updated.end());
+
+		signal_store_type erased, inserted;
+		notify_views(erased, updated, inserted);
+	}
+
 	auto SimpleNotification::Priority() const -> NotificationPriority
 	{
 		return static_cast<NotificationPriority>(m_priority);
@@ -110,6 +138,81 @@ namespace QtTools::NotificationSystem
 		: QObject(parent)
 	{
 		m_store = std::make_shared<NotificationStore>(this);
+
+		m_storeEraseConnection = m_store->on_erase([this](auto erased)
+		{
+			ForgetNotifications(erased.begin(), erased.end());
+		});
+
+		m_storeUpdateConnection = m_store->on_update([this](auto erased, auto updated, auto inserted)
+		{
+			ForgetNotifications(erased.begin(), erased.end());
+		});
+
+		m_storeClearConnection = m_store->on_clear([this]
+		{
+			m_collapseIndex.clear();
+		});
+	}
+
+	std::size_t NotificationCenter::ContentKey(const Notification & notification) const
+	{
+		std::size_t seed = notification.Level();
+		seed = qHash(notification.Title(), seed);
+		seed = qHash(notification.Text(), seed);
+		seed = qHash(notification.ActivationLink(), seed);
+
+		return seed;
+	}
+
+	bool NotificationCenter::SameContent(const Notification & n1, const Notification & n2) const
+	{
+		return n1.Level() == n2.Level()
+		   and n1.Title() == n2.Title()
+		   and n1.Text() == n2.Text()
+		   and n1.ActivationLink() == n2.ActivationLink();
+	}
+
+	auto NotificationCenter::CollapseDuplicate(const Notification & notification) -> const Notification *
+	{
+		if (m_collapseWindow <= std::chrono::milliseconds::zero())
+			return nullptr;
+
+		auto & target = m_collapseIndex[ContentKey(notification)];
+		if (target and SameContent(*target, notification))
+		{
+			auto timestamp = notification.Timestamp();
+			auto distance = std::abs(notification.TimestampMSecs() - target->LastSeen().toMSecsSinceEpoch());
+
+			// center owns stored notifications, they are created as non const objects
+			// and are held by pointer to const only to protect them from views.
+			auto * mtarget = const_cast<Notification *>(target);
+			if (distance <= m_collapseWindow.count() and mtarget->AddOccurrence(std::move(timestamp)))
+				return target;
+		}
+
+		// no duplicate, or it's too old - this notification becomes collapse target for its content
+		target = &notification;
+		return nullptr;
+	}
+
+	void NotificationCenter::ForgetNotifications(const Notification * const * first, const Notification * const * last)
+	{
+		if (m_collapseIndex.empty()) return;
+
+		for (; first != last; ++first)
+		{
+			auto it = m_collapseIndex.find(ContentKey(**first));
+			if (it != m_collapseIndex.end() and it->second == *first)
+				m_collapseIndex.erase(it);
+		}
+	}
+
+	void NotificationCenter::SetCollapseWindow(std::chrono::milliseconds window)
+	{
+		m_collapseWindow = window;
+		if (m_collapseWindow <= std::chrono::milliseconds::zero())
+			m_collapseIndex.clear();
 	}
 
 	auto NotificationCenter::GetStore() -> std::shared_ptr<NotificationStore>
@@ -124,8 +227,64 @@ namespace QtTools::NotificationSystem
 
 	void NotificationCenter::DoAddNotification(const Notification * notification)
 	{
+		if (auto * target = CollapseDuplicate(*notification))
+		{
+			delete notification;
+			m_store->NotifyUpdated({target});
+			Q_EMIT NotificationUpdated(target);
+			return;
+		}
+
 		m_store->push_back(notification);
 		Q_EMIT NotificationAdded(m_store->back());
+		Q_EMIT NotificationsAdded(1);
+	}
+
+	void NotificationCenter::DoAddNotifications(std::vector<std::unique_ptr<const Notification>> notifications)
+	{
+		if (notifications.empty()) return;
+
+		// collapse duplicates, targets can be in store or earlier in this batch
+		std::vector<const Notification *> updated;
+		auto collapse = [this, &updated](auto & notification)
+		{
+			auto * target = CollapseDuplicate(*notification);
+			if (target) updated.push_back(target);
+			return target != nullptr;
+		};
+
+		notifications.erase(std::remove_if(notifications.begin(), notifications.end(), collapse), notifications.end());
+
+		auto count = notifications.size();
+		m_store->append(std::make_move_iterator(notifications.begin()), std::make_move_iterator(notifications.end()));
+
+		auto first = m_store->end() - count;
+		auto last  = m_store->end();
+		for (; first != last; ++first)
+			Q_EMIT NotificationAdded(*first);
+
+		if (count) Q_EMIT NotificationsAdded(static_cast<unsigned>(count));
+		if (updated.empty()) return;
+
+		// targets collapsed within this batch are already appended, updating them once more is harmless
+		std::sort(updated.begin(), updated.end());
+		updated.erase(std::unique(updated.begin(), updated.end()), updated.end());
+		for (auto * notification : updated)
+			Q_EMIT NotificationUpdated(notification);
+
+		m_store->NotifyUpdated(std::move(updated));
+	}
+
+	void NotificationCenter::ProcessPendingNotifications()
+	{
+		decltype(m_pending) pending;
+		{
+			std::lock_guard lk(m_pending_mutex);
+			pending.swap(m_pending);
+			m_should_post = true;
+		}
+
+		DoAddNotifications(std::move(pending));
 	}
 
 	auto NotificationCenter::CreateNotification() const
@@ -143,10 +302,16 @@ namespace QtTools::NotificationSystem
 		}
 		else
 		{
-			QMetaObject::invokeMethod(this, "DoAddNotification", Qt::QueuedConnection,
-				Q_ARG(const Notification *, notification.get()));
-
-			notification.release();
+			bool should_post;
+			{
+				std::lock_guard lk(m_pending_mutex);
+				m_pending.push_back(std::move(notification));
+				should_post = std::exchange(m_should_post, false);
+			}
+
+			// only first notification of a batch posts a drain call, others just join the pending queue
+			if (should_post)
+				QMetaObject::invokeMethod(this, "ProcessPendingNotifications", Qt::QueuedConnection);
 		}
 	}
 
@@ -1,4 +1,5 @@
 #include <QtCore/QStringBuilder>
+#include <QtCore/QMimeData>
 #include <QtGui/QClipboard>
 
 #include <QtWidgets/QShortcut>
@@ -10,7 +11,6 @@
 #include <QtWidgets/QDesktopWidget>
 #include <QtWidgets/QApplication>
 
-#include <ext/join_into.hpp>
 #include <QtTools/ToolsBase.hpp>
 
 #include <QtTools/NotificationSystem/NotificationSystem.hqt>
@@ -99,6 +99,21 @@ namespace QtTools::NotificationSystem
 		Q_EMIT NotificationLevelFilterChanged(m_filteredLevels);
 	}
 
+	void NotificationView::SetCompactMode(bool compact)
+	{
+		if (m_compactMode == compact) return;
+		m_compactMode = compact;
+
+		if (auto * delegate = qobject_cast<NotificationViewDelegate *>(m_listDelegate))
+			delegate->SetCompactMode(compact);
+
+		m_listView->setUniformItemSizes(compact);
+		m_listView->setWordWrap(not compact);
+		if (m_compactAction) m_compactAction->setChecked(compact);
+
+		Q_EMIT CompactModeChanged(m_compactMode);
+	}
+
 	QString NotificationView::ClipboardText(const Notification & n) const
 	{
 		auto title = n.Title();
@@ -110,34 +125,71 @@ namespace QtTools::NotificationSystem
 		     % text;
 	}
 
-	void NotificationView::CopySelectedIntoClipboard()
+	auto NotificationView::MakeClipboardEntry(const Notification & n) const -> ClipboardEntry
 	{
-		using boost::adaptors::transformed;
+		return {ClipboardText(n), n.Text()};
+	}
+
+	auto NotificationView::FormatClipboard(const std::vector<ClipboardEntry> & entries) -> ClipboardData
+	{
+		ClipboardData result;
+		if (entries.empty()) return result;
+
 		//const QChar newPar = QChar::ParagraphSeparator;
-		std::u16string plainsep;
-		plainsep.reserve(82);
-		plainsep += u'\n';
-		plainsep.append(80, u'-');
-		plainsep += u'\n';
+		const QString plainsep = QStringLiteral("\n") + QString(80, '-') + QStringLiteral("\n");
+		const QLatin1String richsep("<hr>");
 
-		std::u16string_view richsep  = u"<hr>";
+		// calculate exact sizes first, then write everything into pre-sized buffers
+		int plainSize = plainsep.size() * (int(entries.size()) - 1);
+		int richSize  = richsep.size()  * (int(entries.size()) - 1);
 
-		QString plainText, richText;
+		for (auto & entry : entries)
+		{
+			plainSize += entry.plainText.size();
+			richSize  += entry.richText.size();
+		}
 
-		auto indexes = m_listView->selectionModel()->selectedRows();
-		auto plainTexts = indexes | transformed([this](auto & idx) { return ClipboardText(m_model->GetItem(idx.row())); });
-		auto richTexts  = indexes | transformed([this](auto & idx) { return m_model->GetItem(idx.row()).Text(); });
+		auto & plainText = result.plainText;
+		auto & richText  = result.richText;
+		plainText.reserve(plainSize);
+		richText.reserve(richSize);
 
-		ext::join_into(plainTexts, plainsep, plainText);
-		ext::join_into(richTexts, richsep, richText);
+		for (std::size_t i = 0; i < entries.size(); ++i)
+		{
+			if (i)
+			{
+				plainText += plainsep;
+				richText += richsep;
+			}
+
+			plainText += entries[i].plainText;
+			richText += entries[i].richText;
+		}
+
+		return result;
+	}
 
+	void NotificationView::SetClipboard(ClipboardData data)
+	{
 		QMimeData * mime = new QMimeData;
-		mime->setText(plainText);
-		mime->setHtml(richText);
+		mime->setText(data.plainText);
+		mime->setHtml(data.richText);
 
 		qApp->clipboard()->setMimeData(mime);
 	}
 
+	void NotificationView::CopySelectedIntoClipboard()
+	{
+		auto indexes = m_listView->selectionModel()->selectedRows();
+
+		std::vector<ClipboardEntry> entries;
+		entries.reserve(indexes.size());
+		for (auto & idx : indexes)
+			entries.push_back(MakeClipboardEntry(m_model->GetItem(idx.row())));
+
+		SetClipboard(FormatClipboard(entries));
+	}
+
 	/************************************************************************/
 	/*                    Init Methods                                      */
 	/************************************************************************/
@@ -221,6 +273,8 @@ namespace QtTools::NotificationSystem
 
 		//m_listView->setResizeMode(QListView::Adjust);
 		//m_listView->setLayoutMode(QListView::SinglePass);
+		// lay out rows in batches, so big lists do not freeze gui while size hints are calculated
+		m_listView->setLayoutMode(QListView::Batched);
 		
 		m_listDelegate = new NotificationViewDelegate(this);
 		m_listView->setItemDelegate(m_listDelegate);
@@ -291,7 +345,14 @@ namespace QtTools::NotificationSystem
 		copyAction->setObjectName("copyAction");
 		connect(copyAction, &QAction::triggered, this, &NotificationView::CopySelectedIntoClipboard);
 
+		m_compactAction = new QAction(tr("Co&mpact view"), this);
+		m_compactAction->setCheckable(true);
+		m_compactAction->setChecked(m_compactMode);
+		m_compactAction->setObjectName("compactAction");
+		connect(m_compactAction, &QAction::toggled, this, &NotificationView::SetCompactMode);
+
 		addAction(copyAction);
+		addAction(m_compactAction);
 		setContextMenuPolicy(Qt::ActionsContextMenu);
 	}
 
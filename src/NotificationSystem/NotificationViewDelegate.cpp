@@ -1,4 +1,7 @@
-﻿#include <QtGui/QPainter>
+﻿#include <algorithm>
+#include <unordered_set>
+
+#include <QtGui/QPainter>
 #include <QtGui/QMouseEvent>
 #include <QtGui/QTextLayout>
 #include <QtGui/QTextDocument>
@@ -17,6 +20,7 @@
 namespace QtTools::NotificationSystem
 {
 	const unsigned NotificationViewDelegate::ms_Spacing = 1;
+	const int NotificationViewDelegate::ms_WidthGranularity = 16;
 	const QMargins NotificationViewDelegate::ms_ContentMargins = {1, 3, 1, 3};
 	const QTextCharFormat NotificationViewDelegate::ms_searchFormat = [] 
 	{
@@ -34,6 +38,18 @@ namespace QtTools::NotificationSystem
 		return ms_ContentMargins + QtTools::Delegates::TextMargins(option);
 	}
 
+	int NotificationViewDelegate::KeyWidth(int width)
+	{
+		if (width < ms_WidthGranularity) return width;
+		return width - width % ms_WidthGranularity;
+	}
+
+	std::size_t NotificationViewDelegate::LayoutCacheKeyHash::operator()(const LayoutCacheKey & key) const noexcept
+	{
+		std::size_t seed = std::hash<const Notification *>()(key.first);
+		return seed ^ (std::hash<int>()(key.second) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+	}
+
 	static void SetText(QTextDocument & textDoc, Qt::TextFormat fmt, QString text)
 	{
 		switch (fmt)
@@ -76,7 +92,7 @@ namespace QtTools::NotificationSystem
 		const auto margins = TextMargins(option);
 		const auto rect = option.rect - margins;
 		const auto topLeft = rect.topLeft();
-		const auto rectWidth = std::max(rect.width(), m_curMaxWidth);
+		const auto rectWidth = item.layoutWidth;
 
 		QPaintDevice * device = const_cast<QWidget *>(option.widget);
 		const QFontMetrics titleFm {item.titleFont, device};
@@ -186,7 +202,7 @@ namespace QtTools::NotificationSystem
 		const auto margins = TextMargins(option);
 		const auto rect = option.rect - margins;
 		const auto topLeft = rect.topLeft();
-		const auto rectWidth = std::max(rect.width(), m_curMaxWidth);
+		const auto rectWidth = item.layoutWidth;
 
 		QPaintDevice * device = const_cast<QWidget *>(option.widget);
 		const QFontMetrics titleFm {item.titleFont, device};
@@ -222,27 +238,9 @@ namespace QtTools::NotificationSystem
 		using namespace QtTools::Delegates::TextLayout;
 
 		item.option = &option;
-		if (item.index == option.index)
-		{
-			auto newTopLeft = option.rect.topLeft();
-			auto diff = newTopLeft - item.hintTopLeft;
-			item.hintTopLeft = newTopLeft;
-
-			item.titleRect.translate(diff);
-			item.timestampRect.translate(diff);
-			item.textRect.translate(diff);
-			item.pixmapRect.translate(diff);
-
-			return;
-		}
-
 		item.hintTopLeft = option.rect.topLeft();
 		item.index = option.index;
 
-		const auto widgetWidth = option.widget->width();
-		if (m_oldViewWidth != widgetWidth and std::exchange(m_oldViewWidth, widgetWidth))
-			m_curMaxWidth = 0;
-
 		auto * model = dynamic_cast<const AbstractNotificationModel *>(option.index.model());
 		if (model) item.searchStr = model->GetFilter();
 
@@ -305,9 +303,10 @@ namespace QtTools::NotificationSystem
 		painter->save();
 		painter->translate(item.textRect.topLeft());
 		
+		// document is already laid out by LayoutText with item.layoutWidth,
+		// setting different width here would relayout it on every paint
 		assert(item.textdocptr);
 		QTextDocument & textDoc = *item.textdocptr;
-		textDoc.setTextWidth(rect.width());
 		textDoc.drawContents(painter);
 
 		painter->restore();
@@ -332,29 +331,318 @@ namespace QtTools::NotificationSystem
 		opt.index = index;
 	}
 
+	void NotificationViewDelegate::TrackModel(const QAbstractItemModel * model) const
+	{
+		if (m_cacheModel == model) return;
+
+		auto * that = ext::unconst(this);
+		if (m_cacheModel) m_cacheModel->disconnect(that);
+		ClearLayoutCache();
+
+		m_cacheModel = model;
+		if (not model) return;
+
+		// rows removal can destroy notifications, and their addresses can be reused by new ones,
+		// data changes can change notifications in place - in any such case cached layouts of those rows are dropped.
+		// Store erasure can also reach model as layoutChanged(viewed models erase records that way) -
+		// after it cached items of notifications no longer present in the model are dropped
+		auto clear = [that] { that->ClearLayoutCache(); };
+		auto removed = [that](const QModelIndex & parent, int first, int last) { that->DropCachedRows(first, last); };
+		auto changed = [that](const QModelIndex & topLeft, const QModelIndex & bottomRight) { that->DropCachedRows(topLeft.row(), bottomRight.row()); };
+		auto relaid = [that] { that->DropStaleItems(); };
+
+		connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, that, removed);
+		connect(model, &QAbstractItemModel::modelAboutToBeReset, that, clear);
+		connect(model, &QAbstractItemModel::dataChanged, that, changed);
+		connect(model, &QAbstractItemModel::layoutChanged, that, relaid);
+	}
+
+	void NotificationViewDelegate::DropCachedRows(int first, int last) const
+	{
+		if (m_layoutCache.empty()) return;
+
+		auto * model = dynamic_cast<const AbstractNotificationModel *>(m_cacheModel.data());
+		if (not model or first < 0 or last < first)
+			return ClearLayoutCache();
+
+		last = std::min(last, model->rowCount() - 1);
+
+		std::unordered_set<const Notification *> dropped;
+		dropped.reserve(last - first + 1);
+		for (int row = first; row <= last; ++row)
+			dropped.insert(&model->GetItem(row));
+
+		for (auto it = m_layoutCache.begin(); it != m_layoutCache.end();)
+		{
+			if (not dropped.count(it->notification))
+				++it;
+			else
+			{
+				m_layoutIndex.erase({it->notification, it->keyWidth});
+				it = m_layoutCache.erase(it);
+			}
+		}
+	}
+
+	void NotificationViewDelegate::DropStaleItems() const
+	{
+		if (m_layoutCache.empty()) return;
+
+		auto * model = dynamic_cast<const AbstractNotificationModel *>(m_cacheModel.data());
+		if (not model) return ClearLayoutCache();
+
+		// cached notifications are never dereferenced, only compared by address,
+		// so dangling ones are safe to look up. Scan stops as soon as all cached notifications are found
+		std::unordered_set<const Notification *> stale;
+		stale.reserve(m_layoutCache.size());
+		for (auto & item : m_layoutCache)
+			stale.insert(item.notification);
+
+		for (int row = 0, count = model->rowCount(); row < count and not stale.empty(); ++row)
+			stale.erase(&model->GetItem(row));
+
+		if (stale.empty()) return;
+
+		for (auto it = m_layoutCache.begin(); it != m_layoutCache.end();)
+		{
+			if (not stale.count(it->notification))
+				++it;
+			else
+			{
+				m_layoutIndex.erase({it->notification, it->keyWidth});
+				it = m_layoutCache.erase(it);
+			}
+		}
+	}
+
+	void NotificationViewDelegate::ClearLayoutCache() const
+	{
+		m_layoutIndex.clear();
+		m_layoutCache.clear();
+	}
+
+	void NotificationViewDelegate::SetLayoutCacheLimit(std::size_t limit)
+	{
+		m_layoutCacheLimit = std::max<std::size_t>(1, limit);
+		while (m_layoutCache.size() > m_layoutCacheLimit)
+		{
+			auto & last = m_layoutCache.back();
+			m_layoutIndex.erase({last.notification, last.keyWidth});
+			m_layoutCache.pop_back();
+		}
+	}
+
+	auto NotificationViewDelegate::CachedItem(const QStyleOptionViewItem & option) const -> LaidoutItem &
+	{
+		auto * model = dynamic_cast<const AbstractNotificationModel *>(option.index.model());
+		assert(model);
+		TrackModel(model);
+
+		// when QAbstractItemView widget is resized - m_curMaxWidth is reset, see its description
+		const auto widgetWidth = option.widget->width();
+		if (m_oldViewWidth != widgetWidth and std::exchange(m_oldViewWidth, widgetWidth))
+			m_curMaxWidth = 0;
+
+		const auto & notification = model->GetItem(option.index.row());
+		const auto rect = option.rect - TextMargins(option);
+		const auto width = std::max(rect.width(), m_curMaxWidth);
+		const auto keyWidth = KeyWidth(width);
+		const LayoutCacheKey key = {&notification, keyWidth};
+
+		auto found = m_layoutIndex.find(key);
+		if (found != m_layoutIndex.end())
+		{
+			auto it = found->second;
+			m_layoutCache.splice(m_layoutCache.begin(), m_layoutCache, it);
+
+			auto & item = *it;
+			// slot holds items with layoutWidth in [keyWidth; keyWidth + ms_WidthGranularity),
+			// laid out text still fits when width grew within the slot - only narrower width needs relayout
+			if (width < item.layoutWidth or item.searchStr != model->GetFilter() or item.baseFont != option.font)
+			{	// width shrunk, search string or font changed - relayout
+				item.layoutWidth = width;
+				LayoutItem(option, item);
+				return item;
+			}
+
+			// just move laidout parts to new position
+			item.option = &option;
+			item.index = option.index;
+
+			auto newTopLeft = option.rect.topLeft();
+			auto diff = newTopLeft - item.hintTopLeft;
+			item.hintTopLeft = newTopLeft;
+
+			item.titleRect.translate(diff);
+			item.timestampRect.translate(diff);
+			item.textRect.translate(diff);
+			item.pixmapRect.translate(diff);
+			item.totalRect.translate(diff);
+
+			return item;
+		}
+
+		if (m_layoutCache.size() >= m_layoutCacheLimit)
+		{
+			auto & last = m_layoutCache.back();
+			m_layoutIndex.erase({last.notification, last.keyWidth});
+			m_layoutCache.pop_back();
+		}
+
+		m_layoutCache.emplace_front();
+		auto & item = m_layoutCache.front();
+		item.notification = &notification;
+		item.layoutWidth = width;
+		item.keyWidth = keyWidth;
+		m_layoutIndex.emplace(key, m_layoutCache.begin());
+
+		LayoutItem(option, item);
+		return item;
+	}
+
+	const QString & NotificationViewDelegate::CompactText(const QStyleOptionViewItem & option, const Notification & notification) const
+	{
+		TrackModel(option.index.model());
+
+		// rich text notification PlainText builds QTextDocument - it must not be done on every paint
+		const LayoutCacheKey key = {&notification, -1};
+		auto found = m_layoutIndex.find(key);
+		if (found != m_layoutIndex.end())
+		{
+			auto it = found->second;
+			m_layoutCache.splice(m_layoutCache.begin(), m_layoutCache, it);
+			return it->text;
+		}
+
+		if (m_layoutCache.size() >= m_layoutCacheLimit)
+		{
+			auto & last = m_layoutCache.back();
+			m_layoutIndex.erase({last.notification, last.keyWidth});
+			m_layoutCache.pop_back();
+		}
+
+		m_layoutCache.emplace_front();
+		auto & item = m_layoutCache.front();
+		item.notification = &notification;
+		item.layoutWidth = item.keyWidth = -1;
+		item.text = notification.PlainText();
+		item.text.replace(QLatin1Char('\n'), QLatin1Char(' '));
+		m_layoutIndex.emplace(key, m_layoutCache.begin());
+
+		return item.text;
+	}
+
+	void NotificationViewDelegate::SetCompactMode(bool compact)
+	{
+		if (m_compactMode == compact) return;
+
+		m_compactMode = compact;
+		m_curMaxWidth = 0;
+		ClearLayoutCache();
+		Q_EMIT sizeHintChanged({});
+	}
+
+	QSize NotificationViewDelegate::CompactSizeHint(const QStyleOptionViewItem & option) const
+	{
+		const auto margins = TextMargins(option);
+		const QFontMetrics fm {option.font, const_cast<QWidget *>(option.widget)};
+		const int iconSz = option.widget->style()->pixelMetric(QStyle::PM_SmallIconSize);
+
+		const int height = std::max(fm.height(), iconSz) + margins.top() + margins.bottom();
+		const int width = std::max(option.rect.width(), 40 * fm.averageCharWidth());
+		return {width, height};
+	}
+
+	void NotificationViewDelegate::DrawCompact(QPainter * painter, const QStyleOptionViewItem & option, const Notification & notification) const
+	{
+		using namespace QtTools::Delegates;
+
+		const bool selected = option.state & QStyle::State_Selected;
+		const auto cg = ColorGroup(option);
+		if (selected) painter->fillRect(option.rect, option.palette.brush(cg, QPalette::Highlight));
+
+		const auto rect = option.rect - TextMargins(option);
+		const auto color = option.palette.color(cg, selected ? QPalette::HighlightedText : QPalette::Text);
+		painter->setPen(color);
+
+		// icon on the left
+		const int iconSz = option.widget->style()->pixelMetric(QStyle::PM_SmallIconSize);
+		QIcon ico;
+		switch (notification.Level())
+		{
+			case QtTools::NotificationSystem::Error: ico = m_errorIcon; break;
+			case QtTools::NotificationSystem::Warn:  ico = m_warnIcon;  break;
+			case QtTools::NotificationSystem::Info:  ico = m_infoIcon;  break;
+		}
+
+		QRect iconRect = {rect.left(), rect.top() + (rect.height() - iconSz) / 2, iconSz, iconSz};
+		ico.paint(painter, iconRect);
+
+		// timestamp on the right
+		QPaintDevice * device = const_cast<QWidget *>(option.widget);
+		const QFontMetrics fm {option.font, device};
+		const auto timestamp = option.widget->locale().toString(notification.Timestamp(), QLocale::ShortFormat);
+		QRect timestampRect = rect;
+		timestampRect.setLeft(rect.right() - fm.width(timestamp));
+
+		painter->setFont(option.font);
+		painter->drawText(timestampRect, Qt::AlignVCenter | Qt::AlignRight, timestamp);
+
+		// bold title and text between them, elided
+		QRect textRect = rect;
+		textRect.setLeft(iconRect.right() + 1 + ms_Spacing);
+		textRect.setRight(timestampRect.left() - 2 * fm.averageCharWidth());
+		if (textRect.width() <= 0) return;
+
+		QFont titleFont = option.font;
+		titleFont.setBold(true);
+		const QFontMetrics titleFm {titleFont, device};
+
+		auto title = titleFm.elidedText(notification.Title(), option.textElideMode, textRect.width());
+		painter->setFont(titleFont);
+		painter->drawText(textRect, Qt::AlignVCenter | Qt::AlignLeft, title);
+
+		textRect.setLeft(textRect.left() + titleFm.width(title) + fm.averageCharWidth());
+		if (textRect.width() <= 0) return;
+
+		// text can be multiline, in compact mode it's joined in one line, see CompactText
+		auto text = fm.elidedText(CompactText(option, notification), option.textElideMode, textRect.width());
+
+		painter->setFont(option.font);
+		painter->drawText(textRect, Qt::AlignVCenter | Qt::AlignLeft, text);
+	}
+
 	void NotificationViewDelegate::paint(QPainter * painter, const QStyleOptionViewItem & option, const QModelIndex & index) const
 	{
 		init(option, index);
-		LayoutItem(option, m_cachedItem);
+		if (m_compactMode)
+		{
+			auto * model = dynamic_cast<const AbstractNotificationModel *>(index.model());
+			DrawCompact(painter, option, model->GetItem(index.row()));
+
+			using namespace QtTools::Delegates;
+			if (HasFocusFrame(option))
+				DrawFocusFrame(painter, option.rect, option);
+
+			return;
+		}
 
-		DrawBackground(painter, m_cachedItem);
-		Draw(painter, m_cachedItem);
+		auto & item = CachedItem(option);
+
+		DrawBackground(painter, item);
+		Draw(painter, item);
 
 		using namespace QtTools::Delegates;
 		if (HasFocusFrame(option))
-			DrawFocusFrame(painter, m_cachedItem.option->rect, option);
+			DrawFocusFrame(painter, item.option->rect, option);
 	}
 
 	QSize NotificationViewDelegate::sizeHint(const QStyleOptionViewItem & option, const QModelIndex & index) const
 	{
-		// sizeHint should always be recalculated
-		// force it by setting invalid index
-		m_cachedItem.index = {};
-
 		init(option, index);
-		LayoutItem(option, m_cachedItem);
+		if (m_compactMode) return CompactSizeHint(option);
 
-		return m_cachedItem.totalRect.size();
+		return CachedItem(option).totalRect.size();
 	}
 
 	bool NotificationViewDelegate::editorEvent(QEvent * event, QAbstractItemModel *, const QStyleOptionViewItem & option, const QModelIndex & index)
@@ -369,24 +657,35 @@ namespace QtTools::NotificationSystem
 		
 		auto * me = static_cast<QMouseEvent *>(event);
 
+		if (m_compactMode)
+		{	// compact mode does not have laid out document, only activation by double click is supported
+			if (evType != QEvent::MouseButtonDblClick) return false;
+
+			auto * model = dynamic_cast<const AbstractNotificationModel *>(index.model());
+			auto href = model->GetItem(index.row()).ActivationLink();
+			if (not href.isEmpty()) LinkActivated(std::move(href), option);
+
+			return true;
+		}
+
 		init(option, index);		
-		LayoutItem(option, m_cachedItem);
+		auto & item = CachedItem(option);
 
 		if (evType == QEvent::MouseButtonDblClick)
 		{
-			if (not m_cachedItem.activationLink.isEmpty())
-				LinkActivated(m_cachedItem.activationLink, option);
+			if (not item.activationLink.isEmpty())
+				LinkActivated(item.activationLink, option);
 
 			return true;
 		}
 
-		assert(m_cachedItem.textdocptr);
-		QTextDocument & textDoc = *m_cachedItem.textdocptr;
+		assert(item.textdocptr);
+		QTextDocument & textDoc = *item.textdocptr;
 		auto * docLayout = textDoc.documentLayout();
 		auto * listView = qobject_cast<const QAbstractItemView *>(option.widget);
 		auto * viewport = listView->viewport();
 		
-		auto docClickPos = me->pos() - m_cachedItem.textRect.topLeft();
+		auto docClickPos = me->pos() - item.textRect.topLeft();
 		QString href = docLayout->anchorAt(docClickPos);
 
 		if (evType == QEvent::MouseMove)
@@ -3,8 +3,31 @@
 #include <QtTools/NotificationSystem/NotificationView.hqt>
 #include <QtTools/NotificationSystem/NotificationViewExt.hqt>
 
+#include <algorithm>  // for std::stable_sort, std::copy_if
+#include <iterator>   // for std::back_inserter
+#include <functional> // for std::cref
+
 namespace QtTools::NotificationSystem
 {
+	bool NotificationSorter::operator()(const Notification & n1, const Notification & n2) const
+	{
+		auto * p1 = &n1;
+		auto * p2 = &n2;
+		// descending order - just swap arguments, stability is preserved
+		if (m_order == Qt::DescendingOrder) std::swap(p1, p2);
+
+		switch (m_key)
+		{
+			case NotificationSortKey::Timestamp: return TimestampPred()(*p1, *p2);
+			case NotificationSortKey::Level:     return p1->Level() < p2->Level();
+			case NotificationSortKey::Priority:  return p1->Priority() < p2->Priority();
+			case NotificationSortKey::Title:     return p1->Title().compare(p2->Title(), Qt::CaseInsensitive) < 0;
+
+			case NotificationSortKey::None:
+			default:                             return false;
+		}
+	}
+
 	viewed::refilter_type NotificationFilter::set_expr(QString search)
 	{
 		if (search.compare(m_filter, Qt::CaseInsensitive) == 0)
@@ -102,6 +125,62 @@ namespace QtTools::NotificationSystem
 		refilter_and_notify(rtype);
 	}
 
+	void NotificationModel::Resort()
+	{
+		if (m_sortKey != NotificationSortKey::None)
+			return sort_by(m_sortKey, m_sortOrder);
+
+		// not sorted means arrival order, which is owner order - restore it
+		beginResetModel();
+		m_sort_pred = {};
+		reinit_view();
+		endResetModel();
+	}
+
+	void NotificationModel::update_data(
+		const signal_range_type & sorted_erased,
+		const signal_range_type & sorted_updated,
+		const signal_range_type & inserted)
+	{
+		if (not sorted_erased.empty() or not sorted_updated.empty())
+			return view_type::update_data(sorted_erased, sorted_updated, inserted);
+
+		store_type newdata;
+		if (not viewed::active(m_filter_pred))
+			newdata.assign(inserted.begin(), inserted.end());
+		else
+			std::copy_if(inserted.begin(), inserted.end(), std::back_inserter(newdata),
+			             [this](auto * ptr) { return m_filter_pred(*ptr); });
+
+		if (newdata.empty()) return;
+
+		if (viewed::active(m_sort_pred))
+		{
+			std::stable_sort(newdata.begin(), newdata.end(), std::cref(m_sort_pred));
+
+			// strictly before current first row - typical for newest first sorting, prepend.
+			// Equal elements go after existing ones, same as stable merge does
+			if (not m_store.empty() and m_sort_pred(newdata.back(), m_store.front()))
+			{
+				beginInsertRows({}, 0, qint(newdata.size()) - 1);
+				m_store.insert(m_store.begin(), newdata.begin(), newdata.end());
+				endInsertRows();
+				return;
+			}
+
+			// neither before first nor after current last row - must be merged
+			if (not m_store.empty() and m_sort_pred(newdata.front(), m_store.back()))
+				return view_type::update_data(sorted_erased, sorted_updated, inserted);
+		}
+
+		int first = qint(m_store.size());
+		int last  = first + qint(newdata.size()) - 1;
+
+		beginInsertRows({}, first, last);
+		m_store.insert(m_store.end(), newdata.begin(), newdata.end());
+		endInsertRows();
+	}
+
 	int NotificationModel::FullRowCount() const
 	{
 		return qint(m_owner->size());
@@ -122,6 +201,18 @@ namespace QtTools::NotificationSystem
 		return SetFiltering(m_filterStr, std::move(filtered));
 	}
 
+	void AbstractNotificationModel::SetSorting(NotificationSortKey key, Qt::SortOrder order)
+	{
+		if (m_sortKey == key and m_sortOrder == order)
+			return;
+
+		m_sortKey = key;
+		m_sortOrder = order;
+
+		Resort();
+		Q_EMIT SortingChanged(m_sortKey, m_sortOrder);
+	}
+
 	void AbstractNotificationModel::SetFiltering(QString expr, NotificationLevelBitset levels)
 	{
 		m_filterStr = std::move(expr);
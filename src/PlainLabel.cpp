@@ -1,4 +1,5 @@
 ﻿#include <QtTools/PlainLabel.hqt>
+#include <algorithm>
 #include <QtGui/QPainter>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QDesktopWidget>
@@ -44,7 +45,7 @@ namespace QtTools
 		const QFontMetrics fm(font);
 
 		const auto  width  = rect.width();
-		const qreal height = std::min(rect.height(), line_limit ? line_limit * fm.height() : maximumHeight());
+		const qreal height = std::min(rect.height(), line_limit > 0 ? line_limit * fm.height() : maximumHeight());
 
 		auto layout = std::make_unique<QTextLayout>(m_text, font, device);
 		const auto textopt = PrepareTextOption();
@@ -123,8 +124,75 @@ namespace QtTools
 		return QtTools::Delegates::TextLayout::NaturalBoundingRect(layout, layout.lineCount()).toAlignedRect();
 	}
 
+	const QTextLayout & PlainLabel::NaturalLayout() const
+	{
+		if (m_natural_layout) return *m_natural_layout;
+
+		QPaintDevice * device = const_cast<PlainLabel *>(this);
+		auto textopt = PrepareTextOption();
+		// no wrapping, alignment is applied by DrawLabel per line
+		textopt.setWrapMode(QTextOption::ManualWrap);
+		textopt.setAlignment(Qt::AlignLeft | Qt::AlignAbsolute);
+
+		auto layout = std::make_unique<QTextLayout>(m_text, font(), device);
+		layout->setCacheEnabled(true);
+		layout->setTextOption(textopt);
+
+		qreal cury = 0;
+		layout->beginLayout();
+		for (;;)
+		{
+			auto line = layout->createLine();
+			if (not line.isValid()) break;
+
+			line.setPosition({0, cury});
+			line.setLineWidth(QWIDGETSIZE_MAX);
+			cury += line.height();
+		}
+
+		layout->endLayout();
+
+		m_natural_rect = NaturalBoundingRect(*layout);
+		m_natural_height = cury;
+		m_natural_layout = std::move(layout);
+		return *m_natural_layout;
+	}
+
+	bool PlainLabel::NaturalLayoutFits(const QRect & rect, int line_limit) const
+	{
+		const auto & layout = NaturalLayout();
+		const QFontMetrics fm(font());
+		const qreal height = std::min(rect.height(), line_limit > 0 ? line_limit * fm.height() : maximumHeight());
+
+		// same conditions as in LayoutText: neither line should be wrapped/elided by width, nor cut by height
+		return m_natural_rect.width() <= rect.width()
+		   and m_natural_height <= height
+		   and (line_limit <= 0 or layout.lineCount() <= line_limit);
+	}
+
+	QRect PlainLabel::LayoutBoundingRect(const QRect & rect, int line_limit) const
+	{
+		if (NaturalLayoutFits(rect, line_limit))
+			return m_natural_rect;
+
+		auto layout = LayoutText(rect, line_limit);
+		return NaturalBoundingRect(*layout);
+	}
+
+	void PlainLabel::ResetLayoutCache()
+	{
+		m_natural_layout = nullptr;
+		m_paint_layout = nullptr;
+		m_size_cache.clear();
+	}
+
 	QSize PlainLabel::sizeForWidth(int width) const
 	{
+		// cache is keyed by requested width: width is adjusted below, -1 for sizeHint must not collide with heightForWidth
+		const int requested_width = width;
+		auto cached = std::find_if(m_size_cache.begin(), m_size_cache.end(), [requested_width](auto & item) { return item.first == requested_width; });
+		if (cached != m_size_cache.end()) return cached->second;
+
 		const QFontMetrics fm(font());
 		const auto indent        = GetIdent(fm);
 		const auto left_indent   = m_alignment & Qt::AlignLeft   ? indent : 0;
@@ -141,27 +209,28 @@ namespace QtTools
 		width = try_width ? std::min(fm.averageCharWidth() * 80, maximum_size.width())
 		                  : width < 0 ? 2000 : width;
 
-		// this is similar to how QLabel calculates size for height
-		auto layout = LayoutText({0, 0, width, default_height}, m_line_limit);
-		auto rect = NaturalBoundingRect(*layout);
+		// this is similar to how QLabel calculates size for height.
+		// LayoutBoundingRect reuses natural layout whenever text fits, so short texts are laid out only once
+		auto rect = LayoutBoundingRect({0, 0, width, default_height}, m_line_limit);
 		auto lc = lines_count(rect);
 		if (try_width and lc < 4 and lc < line_limit and rect.width() > width / 2)
 		{
-			layout = nullptr;
-			layout = LayoutText({0, 0, width / 2, default_height}, m_line_limit);
-			rect = NaturalBoundingRect(*layout);
+			rect = LayoutBoundingRect({0, 0, width / 2, default_height}, m_line_limit);
 			lc = lines_count(rect);
 		}
 
 		if (try_width and lc < 2 and lc < line_limit and rect.width() > width / 4)
 		{
-			layout = nullptr;
-			layout = LayoutText({0, 0, width / 4, default_height}, m_line_limit);
-			rect = NaturalBoundingRect(*layout);
+			rect = LayoutBoundingRect({0, 0, width / 4, default_height}, m_line_limit);
 		}
 
 		rect.adjust(-left_indent, -top_indent, right_indent, bottom_indent);
 		rect.adjust(-m_margin, -m_margin, m_margin, m_margin);
+
+		// few widths are enough: size hint and current width for heightForWidth
+		constexpr std::size_t size_cache_limit = 8;
+		if (m_size_cache.size() >= size_cache_limit) m_size_cache.clear();
+		m_size_cache.emplace_back(requested_width, rect.size());
 		return rect.size();
 	}
 
@@ -211,8 +280,36 @@ namespace QtTools
 		contents_rect.adjust(m_margin, m_margin, -m_margin, -m_margin);
 		contents_rect.adjust(left_indent, top_indent, -right_indent, -bottom_indent);
 
-		auto layout = LayoutText(contents_rect, m_strict_line_limit ? m_line_limit : 0);
-		QtTools::Delegates::TextLayout::DrawLayout(painter, contents_rect.topLeft(), *layout);
+		const auto line_limit = m_strict_line_limit ? m_line_limit : 0;
+		if (NaturalLayoutFits(contents_rect, line_limit))
+		{
+			// natural layout is left aligned - align each line by hand, as QTextLayout would do for contents_rect width
+			const auto & layout = NaturalLayout();
+			const auto align = QStyle::visualAlignment(TextDirection(), m_alignment);
+			const qreal width = contents_rect.width();
+
+			for (int i = 0, lc = layout.lineCount(); i < lc; ++i)
+			{
+				auto line = layout.lineAt(i);
+				qreal dx = 0;
+				if      (align & Qt::AlignRight)   dx = width - line.naturalTextWidth();
+				else if (align & Qt::AlignHCenter) dx = (width - line.naturalTextWidth()) / 2;
+
+				line.draw(painter, contents_rect.topLeft() + QPointF(dx, 0));
+			}
+
+			return;
+		}
+
+		// text needs wrapping/eliding - reuse previous layout if geometry did not change
+		if (not m_paint_layout or m_paint_rect != contents_rect or m_paint_line_limit != line_limit)
+		{
+			m_paint_layout = LayoutText(contents_rect, line_limit);
+			m_paint_rect = contents_rect;
+			m_paint_line_limit = line_limit;
+		}
+
+		QtTools::Delegates::TextLayout::DrawLayout(painter, contents_rect.topLeft(), *m_paint_layout);
 	}
 
 	void PlainLabel::paintEvent(QPaintEvent * event)
@@ -224,6 +321,22 @@ namespace QtTools
 		DrawLabel(&painter);
 	}
 
+	void PlainLabel::changeEvent(QEvent * event)
+	{
+		switch (event->type())
+		{
+			case QEvent::FontChange:
+			case QEvent::StyleChange:
+				// cached layouts and size hints are font dependent
+				UpdateLabel();
+				break;
+
+			default: break;
+		}
+
+		QFrame::changeEvent(event);
+	}
+
 	void PlainLabel::UpdateLabel()
 	{
 		auto pol = sizePolicy();
@@ -232,13 +345,33 @@ namespace QtTools
 
 		//m_cached_minimum_size_hint = {};
 		m_cached_size_hint = {};
+		ResetLayoutCache();
 		updateGeometry();
 		update();
 	}
 
 	void PlainLabel::setText(QString text)
 	{
+		// status labels are often updated with the very same text
+		if (m_text == text) return;
+
 		m_text = std::move(text);
+
+		// if size hint does not change - there is no need to recalculate parent layout, only repaint.
+		// With word wrap size depends on width in a more complex way - do full update
+		auto old_size_hint = m_cached_size_hint;
+		if (old_size_hint.isValid() and not m_word_wrap)
+		{
+			ResetLayoutCache();
+			m_cached_size_hint = {};
+
+			if (sizeHint() == old_size_hint)
+			{
+				update();
+				return;
+			}
+		}
+
 		UpdateLabel();
 	}
 
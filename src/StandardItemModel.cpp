@@ -1,63 +1,26 @@
 #include <QtTools/StandardItemModel.hqt>
-#include <iterator>
-#include <algorithm>
-#include <ext/algorithm.hpp>
-
-#include <boost/iterator/iterator_facade.hpp>
-#include <boost/assert.hpp>
+#include <utility>
 
 namespace QtTools
 {
-	namespace
+	QStandardItem * StandardItemModel::ParentItem(const QModelIndex & parent)
 	{
-		/// ссылка на StandardItemModel Item по номеру строки,
-		/// умеет обменивать строки, фактически адаптер для стандартных алгоритмов
-		struct RowItemReference
-		{
-			StandardItemModel * owner;
-			int row;
-		};
-
-		void swap(RowItemReference op1, RowItemReference op2)
-		{
-			BOOST_ASSERT(op1.owner == op2.owner);
-			op1.owner->SwapRows(op1.row, op2.row);
-		}
-
-		struct RowIterator :
-			public boost::iterator_facade<
-				RowIterator,
-				RowItemReference,
-				std::random_access_iterator_tag,
-				RowItemReference
-			>
-		{
-			StandardItemModel * owner;
-			int row;
-
-			RowIterator(StandardItemModel * owner, int row) : owner(owner), row(row) {}
-
-			RowItemReference dereference() const { return RowItemReference{ owner, row }; }
-			bool equal(const RowIterator & other) const { return row == other.row; }
-			void increment() { ++row; }
-			void decrement() { --row; }
-			void advance(std::ptrdiff_t step) { row += step; }
-			std::ptrdiff_t distance_to(const RowIterator & other) const { return other.row - row; }
-		};
+		return parent.isValid() ? itemFromIndex(parent) : invisibleRootItem();
 	}
 
 	void StandardItemModel::SwapRows(int row1, int row2)
 	{
-		for (int i = 0, n = columnCount(); i < n; ++i)
-		{
-			auto idx1 = index(row1, i);
-			auto idx2 = index(row2, i);
-			auto itd1 = itemData(idx1);
-			auto itd2 = itemData(idx2);
+		if (row1 == row2) return;
+		if (row1 > row2) std::swap(row1, row2);
 
-			setItemData(idx1, itd2);
-			setItemData(idx2, itd1);
-		}
+		// строки переставляются целиком: takeRow/insertRow переносят сами элементы вместе с поддеревьями,
+		// модель генерирует только rowsRemoved/rowsInserted по каждой из двух строк
+		auto * parentItem = invisibleRootItem();
+		auto items2 = parentItem->takeRow(row2);
+		auto items1 = parentItem->takeRow(row1);
+
+		parentItem->insertRow(row1, items2);
+		parentItem->insertRow(row2, items1);
 	}
 
 	bool StandardItemModel::moveRows(const QModelIndex & sourceParent, int sourceRow, int count,
@@ -66,15 +29,41 @@ namespace QtTools
 		if (sourceParent != destinationParent)
 			return false;
 
-		bool allowed = beginMoveRows(sourceParent, sourceRow, sourceRow + count - 1, destinationParent, destinationChild);
-		if (!allowed) return false;
-
-		RowIterator first {this, sourceRow};
-		RowIterator last {this, sourceRow + count};
-		RowIterator new_pos {this, destinationChild};
-		ext::slide(first, last, new_pos);
+		auto * parentItem = ParentItem(sourceParent);
+		if (not parentItem) return false;
+
+		int nrows = parentItem->rowCount();
+		if (count <= 0 or sourceRow < 0 or sourceRow + count > nrows) return false;
+		if (destinationChild < 0 or destinationChild > nrows) return false;
+		// same as beginMoveRows: moving into itself is not a move
+		if (destinationChild >= sourceRow and destinationChild <= sourceRow + count) return false;
+
+		// moving rows is a left rotate of affected rows [first; last) around middle:
+		// new order is [middle; last) + [first; middle)
+		int first, middle, last;
+		if (destinationChild < sourceRow)
+			first = destinationChild, middle = sourceRow, last = sourceRow + count;
+		else
+			first = sourceRow, middle = sourceRow + count, last = destinationChild;
+
+		// items can't be moved inside beginMoveRows/endMoveRows: takeChild/setChild detach an item from the model,
+		// which invalidates its persistent index before endMoveRows gets to remap it,
+		// and emit layoutChanged/itemChanged for every cell.
+		// Whole rows are relocated with takeRow/insertRow instead - rows with their subtrees are moved as is,
+		// the model emits only rowsRemoved/rowsInserted per row. Smaller of two blocks is moved.
+		if (middle - first <= last - middle)
+		{
+			// [first; middle) goes to the end of the range
+			for (int i = first; i < middle; ++i)
+				parentItem->insertRow(last - 1, parentItem->takeRow(first));
+		}
+		else
+		{
+			// [middle; last) goes to the beginning of the range
+			for (int i = middle; i < last; ++i)
+				parentItem->insertRow(first, parentItem->takeRow(last - 1));
+		}
 
-		endMoveRows();
 		return true;
 	}
 
@@ -47,6 +47,7 @@ namespace QtTools
 		{
 			std::lock_guard lk(m_mutex);
 			tasks = std::move(m_tasks);
+			m_keyed.clear();
 			m_should_emit = true;
 		}
 
@@ -98,6 +99,7 @@ namespace QtTools
 			// wait until all delayed_tasks are finished, and take pending tasks
 			m_event.wait(lk, [this] { return m_delayed_count == 0; });
 			tasks.swap(m_tasks);
+			m_keyed.clear();
 		}
 
 		tasks.clear_and_dispose([](task_base * task)
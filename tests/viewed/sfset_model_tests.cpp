@@ -241,4 +241,65 @@ BOOST_AUTO_TEST_CASE(advanced_filter_tests)
 	BOOST_CHECK_EQUAL_COLLECTIONS(model.begin(), model.end(), expected_data.begin(), expected_data.end());
 }
 
+BOOST_AUTO_TEST_CASE(bulk_erase_tests)
+{
+	using model_type = sfset_model<int, std::less<>, nratio_filter>;
+	model_type model;
+
+	auto assign_data = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+	assign(model, assign_data);
+
+	QPersistentModelIndex idx1 = model.index(4);
+	QPersistentModelIndex idx2 = model.index(8);
+	BOOST_CHECK_EQUAL(idx1.data().toInt(), 4);
+	BOOST_CHECK_EQUAL(idx2.data().toInt(), 8);
+
+	// one contiguous run, duplicate and not existing keys are ignored
+	auto erase_data = {2, 3, 3, 100};
+	BOOST_CHECK_EQUAL(erase(model, erase_data), 2);
+
+	std::initializer_list<int> expected_data = {0, 1, 4, 5, 6, 7, 8, 9};
+	BOOST_CHECK_EQUAL_COLLECTIONS(model.begin(), model.end(), expected_data.begin(), expected_data.end());
+	BOOST_CHECK_EQUAL(idx1.row(), 2);
+	BOOST_CHECK_EQUAL(idx2.row(), 6);
+
+	// scattered runs
+	erase_data = {9, 0, 5, 6};
+	BOOST_CHECK_EQUAL(erase(model, erase_data), 4);
+
+	expected_data = {1, 4, 7, 8};
+	BOOST_CHECK_EQUAL_COLLECTIONS(model.begin(), model.end(), expected_data.begin(), expected_data.end());
+	BOOST_CHECK_EQUAL(model.rowCount(), 4);
+	BOOST_CHECK(idx1.isValid() and idx1.row() == 1);
+	BOOST_CHECK(idx2.isValid() and idx2.row() == 3);
+
+	// shadow elements: 4 and 8 are filtered out
+	model.filter_by(2);
+	expected_data = {1, 7};
+	BOOST_CHECK_EQUAL_COLLECTIONS(model.begin(), model.end(), expected_data.begin(), expected_data.end());
+
+	QPersistentModelIndex idx3 = model.index(0);
+	BOOST_CHECK_EQUAL(idx3.data().toInt(), 1);
+
+	erase_data = {7, 8};
+	BOOST_CHECK_EQUAL(erase(model, erase_data), 2);
+	BOOST_CHECK_EQUAL(model.rowCount(), 1);
+	BOOST_CHECK(idx3.isValid() and idx3.row() == 0);
+
+	model.filter_by(0);
+	expected_data = {1, 4};
+	BOOST_CHECK_EQUAL_COLLECTIONS(model.begin(), model.end(), expected_data.begin(), expected_data.end());
+}
+
+BOOST_AUTO_TEST_CASE(heterogeneous_key_tests)
+{
+	using hash_type = viewed::sfset_key_hash<std::string>;
+	static_assert(std::is_invocable_v<const hash_type &, std::string_view>);
+	static_assert(std::is_invocable_v<const hash_type &, const char *>);
+
+	hash_type hash;
+	BOOST_CHECK_EQUAL(hash(std::string("test")), std::hash<std::string>()("test"));
+	BOOST_CHECK_EQUAL(hash(std::string_view("test")), std::hash<std::string>()("test"));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
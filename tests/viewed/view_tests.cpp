@@ -177,4 +177,28 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(sfview_qtbase_presistance_test, view_type, persist
 	BOOST_CHECK_EQUAL(view.index(1).data().toInt(), 7);
 }
 
+BOOST_AUTO_TEST_CASE(coalesce_changed_test)
+{
+	std::vector<int> changed = {0, 1, 2, 5, 7, 8, 12};
+	std::vector<std::pair<int, int>> ranges, expected;
+	auto collect = [&ranges](int top, int bottom) { ranges.emplace_back(top, bottom); };
+
+	viewed::emit_changed_policy policy;
+	viewed::coalesce_changed(changed.begin(), changed.end(), 100, policy, collect);
+	expected = {{0, 2}, {5, 5}, {7, 8}, {12, 12}};
+	BOOST_CHECK(ranges == expected);
+
+	ranges.clear();
+	policy.max_gap = 2;
+	viewed::coalesce_changed(changed.begin(), changed.end(), 100, policy, collect);
+	expected = {{0, 8}, {12, 12}};
+	BOOST_CHECK(ranges == expected);
+
+	ranges.clear();
+	policy.whole_ratio = 0.5;
+	viewed::coalesce_changed(changed.begin(), changed.end(), 14, policy, collect);
+	expected = {{0, 13}};
+	BOOST_CHECK(ranges == expected);
+}
+
 BOOST_AUTO_TEST_SUITE_END()